@@ -0,0 +1,62 @@
+#include "allocation_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<int> activeCounters{0};
+std::atomic<std::uint64_t> allocations{0};
+
+}
+
+void startCountingAllocations() {
+    activeCounters.fetch_add(1, std::memory_order_relaxed);
+}
+
+void stopCountingAllocations() {
+    activeCounters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+std::uint64_t allocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size) {
+    if (activeCounters.load(std::memory_order_relaxed) > 0) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (size == 0) {
+        size = 1;
+    }
+    while (true) {
+        if (void* memory = std::malloc(size)) {
+            return memory;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
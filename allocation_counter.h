@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdint>
+
+// Counts heap allocations made through operator new anywhere in the program. Counting is off until some
+// caller starts it and stays on until every caller that started it has stopped.
+void startCountingAllocations();
+void stopCountingAllocations();
+[[nodiscard]] std::uint64_t allocationCount();
@@ -0,0 +1,444 @@
+// Timings for the hot paths of the board on a generated scene. Build from the repository root with
+//   g++ -std=c++17 -O2 -pthread -o bench/bench bench/bench.cpp $(ls *.cpp | grep -v '^main.cpp$')
+// Results are printed to stdout as one JSON document; run with --help for the scene options.
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../board.h"
+#include "../command.h"
+#include "../framebuffer.h"
+#include "../ingest.h"
+#include "../tokenizer.h"
+
+namespace {
+
+struct SceneSpec {
+    int boardWidth = 400;
+    int boardHeight = 200;
+    int figureCount = 5000;
+    std::array<int, 4> shapeMix{1, 1, 1, 1};   // weights in ShapeType order
+    int minSize = 2;
+    int maxSize = 20;
+    double fillRatio = 0.5;
+    unsigned seed = 1;
+    int repeats = 5;
+    std::string only;
+};
+
+struct GeneratedFigure {
+    ShapeType type;
+    int x;
+    int y;
+    int param1;
+    int param2;
+    ColorName color;
+    FillMode fillMode;
+
+    [[nodiscard]] Shape toShape() const { return Shape::create(type, x, y, param1, param2, Color(color), fillMode); }
+};
+
+std::vector<GeneratedFigure> generateScene(const SceneSpec& spec, const std::array<int, 4>& shapeMix, unsigned seed) {
+    std::mt19937 random(seed);
+    std::discrete_distribution<int> pickType(shapeMix.begin(), shapeMix.end());
+    std::uniform_int_distribution<int> pickX(0, spec.boardWidth - 1);
+    std::uniform_int_distribution<int> pickY(0, spec.boardHeight - 1);
+    std::uniform_int_distribution<int> pickSize(spec.minSize, spec.maxSize);
+    std::uniform_int_distribution<int> pickColor(0, static_cast<int>(ColorName::White));
+    std::bernoulli_distribution pickFill(spec.fillRatio);
+
+    std::vector<GeneratedFigure> scene;
+    scene.reserve(spec.figureCount);
+    for (int i = 0; i < spec.figureCount; ++i) {
+        GeneratedFigure figure{};
+        figure.type = static_cast<ShapeType>(pickType(random));
+        figure.x = pickX(random);
+        figure.y = pickY(random);
+        figure.param1 = pickSize(random);
+        figure.param2 = pickSize(random);
+        if (figure.type == ShapeType::Line) {
+            figure.param1 = figure.x + figure.param1 - spec.maxSize / 2;
+            figure.param2 = figure.y + figure.param2 - spec.maxSize / 2;
+        }
+        else if (figure.type != ShapeType::Rectangle) {
+            figure.param2 = 0;
+        }
+        figure.color = static_cast<ColorName>(pickColor(random));
+        figure.fillMode = pickFill(random) ? FillMode::Fill : FillMode::Frame;
+        scene.push_back(figure);
+    }
+    return scene;
+}
+
+std::string addCommand(const GeneratedFigure& figure) {
+    static const char* const shapeNames[] = {"triangle", "rectangle", "circle", "line"};
+    static const char* const colorNames[] = {"red", "green", "blue", "yellow", "cyan", "magenta", "white"};
+    std::string line = figure.fillMode == FillMode::Fill ? "add fill " : "add frame ";
+    line += colorNames[static_cast<int>(figure.color)];
+    line += ' ';
+    line += shapeNames[static_cast<int>(figure.type)];
+    line += ' ' + std::to_string(figure.x) + ' ' + std::to_string(figure.y) + ' ' + std::to_string(figure.param1);
+    if (figure.type == ShapeType::Rectangle || figure.type == ShapeType::Line) {
+        line += ' ' + std::to_string(figure.param2);
+    }
+    return line;
+}
+
+// Swallows everything the board prints, so draw timings include formatting but not the terminal.
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize count) override { return count; }
+};
+
+NullBuffer nullBuffer;
+std::ostream nullStream(&nullBuffer);
+
+void populate(Board& board, const std::vector<GeneratedFigure>& scene) {
+    board.setOutput(nullStream, nullStream);
+    board.setQuiet(true);
+    for (const GeneratedFigure& figure : scene) {
+        board.add(figure.type, figure.color, figure.x, figure.y, figure.param1, figure.param2, figure.fillMode);
+    }
+}
+
+struct Result {
+    std::string name;
+    std::size_t operations;
+    std::vector<double> seconds;
+    std::vector<std::pair<std::string, double>> counters;
+};
+
+class Suite {
+public:
+    explicit Suite(const SceneSpec& spec) : spec(spec) {}
+
+    // Runs setup untimed and then body timed, once per repeat. Returns false if the name was filtered out.
+    bool measure(const std::string& name, std::size_t operations, const std::function<void()>& setup, const std::function<void()>& body) {
+        if (name.compare(0, spec.only.size(), spec.only) != 0) {
+            return false;
+        }
+        Result result{name, operations, {}, {}};
+        for (int i = 0; i < spec.repeats; ++i) {
+            setup();
+            auto start = std::chrono::steady_clock::now();
+            body();
+            result.seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::sort(result.seconds.begin(), result.seconds.end());
+        std::cerr << name << ": " << result.seconds.front() * 1e3 << " ms\n";
+        results.push_back(std::move(result));
+        return true;
+    }
+
+    // Attaches a value from the last repeat to the benchmark measured last.
+    void annotate(const std::string& counter, double value) {
+        results.back().counters.emplace_back(counter, value);
+    }
+
+    void writeJson(std::ostream& output) const {
+        output << "{\n  \"scene\": {\"width\": " << spec.boardWidth << ", \"height\": " << spec.boardHeight
+               << ", \"figures\": " << spec.figureCount << ", \"mix\": [" << spec.shapeMix[0] << ", " << spec.shapeMix[1]
+               << ", " << spec.shapeMix[2] << ", " << spec.shapeMix[3] << "], \"min_size\": " << spec.minSize
+               << ", \"max_size\": " << spec.maxSize << ", \"fill_ratio\": " << spec.fillRatio << ", \"seed\": " << spec.seed
+               << "},\n  \"threads\": " << std::thread::hardware_concurrency() << ",\n  \"repeats\": " << spec.repeats
+               << ",\n  \"results\": [";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            const Result& result = results[i];
+            double best = result.seconds.front();
+            double median = result.seconds[result.seconds.size() / 2];
+            output << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << result.name << "\", \"operations\": " << result.operations
+                   << ", \"min_seconds\": " << best << ", \"median_seconds\": " << median << ", \"ns_per_operation\": "
+                   << (result.operations > 0 ? best * 1e9 / static_cast<double>(result.operations) : 0.0);
+            for (const auto& [counter, value] : result.counters) {
+                output << ", \"" << counter << "\": " << value;
+            }
+            output << "}";
+        }
+        output << "\n  ]\n}\n";
+    }
+
+private:
+    const SceneSpec& spec;
+    std::vector<Result> results;
+};
+
+void benchmarkDraw(Suite& suite, const SceneSpec& spec, const std::vector<GeneratedFigure>& scene) {
+    Board board(spec.boardWidth, spec.boardHeight);
+    populate(board, scene);
+    std::size_t figures = board.getFigures().size();
+
+    std::vector<Rect> tiles;
+    suite.measure("draw.render", figures, [&] { board.markAllDirty(); }, [&] { board.render(tiles); });
+    suite.measure("draw.print", figures, [&] { board.markAllDirty(); }, [&] { board.draw(); });
+
+    // A single figure changing between draws is the common interactive case.
+    board.draw();
+    board.setDisplayMode(DisplayMode::Incremental);
+    int target = board.getFigures().empty() ? -1 : board.getFigures().begin()->id;
+    suite.measure("draw.incremental", 1, [&] {
+        board.select(target);
+        board.paint("red");
+        board.paint("blue");
+    }, [&] { board.draw(); });
+}
+
+// Every kernel draws each figure into the tiles its bounds cover, clipped exactly as render() clips it.
+void benchmarkKernels(Suite& suite, const SceneSpec& spec) {
+    static const char* const names[] = {"kernel.triangle", "kernel.rectangle", "kernel.circle", "kernel.line"};
+    Rect boardRect{0, 0, spec.boardWidth - 1, spec.boardHeight - 1};
+    for (int type = 0; type < 4; ++type) {
+        std::array<int, 4> mix{};
+        mix[type] = 1;
+        std::vector<Shape> shapes;
+        for (const GeneratedFigure& figure : generateScene(spec, mix, spec.seed + 1 + type)) {
+            shapes.push_back(figure.toShape());
+        }
+
+        Framebuffer::Tile tile(Framebuffer::tileArea(0, 0));
+        suite.measure(names[type], shapes.size(), [] {}, [&] {
+            for (const Shape& shape : shapes) {
+                Rect bounds = shape.getBounds().intersected(boardRect);
+                if (bounds.empty()) {
+                    continue;
+                }
+                for (int y = bounds.top - bounds.top % Framebuffer::tileSize; y <= bounds.bottom; y += Framebuffer::tileSize) {
+                    for (int x = bounds.left - bounds.left % Framebuffer::tileSize; x <= bounds.right; x += Framebuffer::tileSize) {
+                        tile.area = Framebuffer::tileArea(x, y);
+                        shape.draw(tile, tile.area.intersected(bounds));
+                    }
+                }
+            }
+        });
+    }
+}
+
+void benchmarkFiles(Suite& suite, const SceneSpec& spec, const std::vector<GeneratedFigure>& scene) {
+    Board board(spec.boardWidth, spec.boardHeight);
+    populate(board, scene);
+    std::size_t figures = board.getFigures().size();
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path();
+    std::string textPath = (directory / ("bench_scene_" + std::to_string(spec.seed) + ".txt")).string();
+    std::string binaryPath = (directory / ("bench_scene_" + std::to_string(spec.seed) + ".bin")).string();
+
+    Board loaded(spec.boardWidth, spec.boardHeight);
+    loaded.setOutput(nullStream, nullStream);
+    loaded.setQuiet(true);
+    suite.measure("file.save_text", figures, [] {}, [&] { board.save(textPath); });
+    suite.measure("file.load_text", figures, [] {}, [&] { loaded.load(textPath); });
+    suite.measure("file.save_binary", figures, [] {}, [&] { board.saveBinary(binaryPath); });
+    suite.measure("file.load_binary", figures, [] {}, [&] { loaded.loadBinary(binaryPath); });
+
+    std::error_code ignored;
+    std::filesystem::remove(textPath, ignored);
+    std::filesystem::remove(binaryPath, ignored);
+}
+
+void benchmarkQueries(Suite& suite, const SceneSpec& spec, const std::vector<GeneratedFigure>& scene) {
+    Board board(spec.boardWidth, spec.boardHeight);
+    populate(board, scene);
+
+    // Half of the probes are figures on the board and half are fresh ones from a different seed.
+    std::vector<Shape> probes;
+    for (const GeneratedFigure& figure : scene) {
+        probes.push_back(figure.toShape());
+    }
+    for (const GeneratedFigure& figure : generateScene(spec, spec.shapeMix, spec.seed + 100)) {
+        probes.push_back(figure.toShape());
+    }
+    std::size_t duplicates = 0;
+    suite.measure("query.is_duplicate", probes.size(), [&] { duplicates = 0; }, [&] {
+        for (const Shape& probe : probes) {
+            duplicates += board.isDuplicate(probe);
+        }
+    });
+
+    std::mt19937 random(spec.seed);
+    std::uniform_int_distribution<int> pickX(0, spec.boardWidth - 1);
+    std::uniform_int_distribution<int> pickY(0, spec.boardHeight - 1);
+    std::vector<std::pair<int, int>> points(10000);
+    for (auto& point : points) {
+        point = {pickX(random), pickY(random)};
+    }
+    suite.measure("query.select_point", points.size(), [] {}, [&] {
+        for (const auto& [x, y] : points) {
+            board.select(x, y);
+        }
+    });
+}
+
+void benchmarkCommands(Suite& suite, const SceneSpec& spec, const std::vector<GeneratedFigure>& scene) {
+    std::vector<std::string> adds;
+    for (const GeneratedFigure& figure : scene) {
+        adds.push_back(addCommand(figure));
+    }
+
+    std::unique_ptr<Board> board;
+    auto freshBoard = [&] {
+        board = std::make_unique<Board>(spec.boardWidth, spec.boardHeight);
+        board->setOutput(nullStream, nullStream);
+        board->setQuiet(true);
+    };
+    suite.measure("command.add", adds.size(), freshBoard, [&] {
+        for (const std::string& line : adds) {
+            executeCommand(*board, line);
+        }
+    });
+
+    // Edits select a figure by point, then repaint or move it and take the change back, as a user would.
+    std::mt19937 random(spec.seed);
+    std::uniform_int_distribution<std::size_t> pickFigure(0, scene.empty() ? 0 : scene.size() - 1);
+    std::vector<std::string> edits;
+    for (std::size_t i = 0; i < scene.size() && edits.size() < 3000; ++i) {
+        const GeneratedFigure& figure = scene[pickFigure(random)];
+        std::string at = std::to_string(figure.x) + ' ' + std::to_string(figure.y);
+        edits.push_back("select " + at);
+        edits.push_back(i % 2 == 0 ? "paint green" : "move " + at);
+        edits.push_back("undo");
+    }
+    suite.measure("command.edit", edits.size(), [&] {
+        freshBoard();
+        populate(*board, scene);
+    }, [&] {
+        for (const std::string& line : edits) {
+            executeCommand(*board, line);
+        }
+    });
+}
+
+// Producers feed the generated adds, plus a move and a paint for every fourth one, through the ingest queue.
+void benchmarkIngest(Suite& suite, const SceneSpec& spec, const std::vector<GeneratedFigure>& scene) {
+    std::vector<Board::Operation> operations;
+    for (std::size_t i = 0; i < scene.size(); ++i) {
+        const GeneratedFigure& figure = scene[i];
+        operations.push_back({Board::Operation::Type::Add, figure.type, figure.color, figure.fillMode, 0, figure.x, figure.y, figure.param1, figure.param2});
+        if (i % 4 == 3) {
+            int target = static_cast<int>(i / 2);
+            operations.push_back({Board::Operation::Type::Move, ShapeType::Invalid, ColorName::Invalid, FillMode::Frame, target, figure.y % spec.boardWidth,
+                                  figure.x % spec.boardHeight, 0, 0});
+            operations.push_back({Board::Operation::Type::Paint, ShapeType::Invalid, figure.color, FillMode::Frame, target, 0, 0, 0, 0});
+        }
+    }
+
+    std::size_t producers = std::max(2u, std::thread::hardware_concurrency());
+    std::unique_ptr<Board> board;
+    IngestQueue::Metrics metrics{};
+    bool ran = suite.measure("ingest.queue", operations.size(), [&] {
+        board = std::make_unique<Board>(spec.boardWidth, spec.boardHeight);
+        board->setOutput(nullStream, nullStream);
+        board->setQuiet(true);
+    }, [&] {
+        IngestQueue queue(*board, nullptr, 1 << 12);
+        std::vector<std::thread> threads;
+        for (std::size_t producer = 0; producer < producers; ++producer) {
+            threads.emplace_back([&, producer] {
+                for (std::size_t i = producer; i < operations.size(); i += producers) {
+                    queue.push(operations[i]);
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        queue.flush();
+        metrics = queue.metrics();
+    });
+    if (ran) {
+        suite.annotate("producers", static_cast<double>(producers));
+        suite.annotate("batches", static_cast<double>(metrics.batches));
+        suite.annotate("rejected", static_cast<double>(metrics.rejected));
+        suite.annotate("max_depth", static_cast<double>(metrics.maxDepth));
+        suite.annotate("stalled_pushes", static_cast<double>(metrics.stalledPushes));
+        suite.annotate("stall_seconds", static_cast<double>(metrics.stallNanoseconds) / 1e9);
+    }
+}
+
+bool parsePair(std::string_view text, int& first, int& second) {
+    Tokenizer tokens(text);
+    return tokens.nextInt(first) && tokens.nextInt(second) && tokens.atEnd();
+}
+
+bool parseOptions(int argc, char* argv[], SceneSpec& spec) {
+    for (int i = 1; i < argc; ++i) {
+        std::string_view option = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string_view value = argv[++i];
+        bool valid;
+        if (option == "--width") {
+            valid = Tokenizer::parseInt(value, spec.boardWidth) && spec.boardWidth > 0;
+        }
+        else if (option == "--height") {
+            valid = Tokenizer::parseInt(value, spec.boardHeight) && spec.boardHeight > 0;
+        }
+        else if (option == "--figures") {
+            valid = Tokenizer::parseInt(value, spec.figureCount) && spec.figureCount >= 0;
+        }
+        else if (option == "--mix") {
+            Tokenizer tokens(value);
+            valid = true;
+            for (int& weight : spec.shapeMix) {
+                valid = valid && tokens.nextInt(weight) && weight >= 0;
+            }
+            valid = valid && tokens.atEnd() && spec.shapeMix[0] + spec.shapeMix[1] + spec.shapeMix[2] + spec.shapeMix[3] > 0;
+        }
+        else if (option == "--size") {
+            valid = parsePair(value, spec.minSize, spec.maxSize) && spec.minSize > 0 && spec.minSize <= spec.maxSize;
+        }
+        else if (option == "--fill") {
+            int percent;
+            valid = Tokenizer::parseInt(value, percent) && percent >= 0 && percent <= 100;
+            spec.fillRatio = percent / 100.0;
+        }
+        else if (option == "--seed") {
+            int seed;
+            valid = Tokenizer::parseInt(value, seed);
+            spec.seed = static_cast<unsigned>(seed);
+        }
+        else if (option == "--repeats") {
+            valid = Tokenizer::parseInt(value, spec.repeats) && spec.repeats > 0;
+        }
+        else if (option == "--only") {
+            spec.only = value;
+            valid = true;
+        }
+        else {
+            valid = false;
+        }
+        if (!valid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    SceneSpec spec;
+    if (!parseOptions(argc, argv, spec)) {
+        std::cerr << "Usage: " << argv[0] << " [--width N] [--height N] [--figures N] [--mix triangle,rectangle,circle,line]"
+                  << " [--size min,max] [--fill percent] [--seed N] [--repeats N] [--only name-prefix]" << std::endl;
+        return 2;
+    }
+
+    std::vector<GeneratedFigure> scene = generateScene(spec, spec.shapeMix, spec.seed);
+    Suite suite(spec);
+    benchmarkDraw(suite, spec, scene);
+    benchmarkKernels(suite, spec);
+    benchmarkFiles(suite, spec, scene);
+    benchmarkQueries(suite, spec, scene);
+    benchmarkCommands(suite, spec, scene);
+    benchmarkIngest(suite, spec, scene);
+    suite.writeJson(std::cout);
+    return 0;
+}
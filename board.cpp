@@ -1,427 +1,1745 @@
 #include "board.h"
 #include "fstream"
 #include <iostream>
-#include <iomanip>
+#include <array>
 #include "enums.h"
 #include "algorithm"
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <unordered_set>
+#include "coverage.h"
+#include "tile_set.h"
+#include "scene_file.h"
+#include "scene_parser.h"
+
+namespace {
+
+constexpr std::size_t cellKinds = static_cast<std::size_t>(ColorName::Invalid) + 1;
+
+const std::array<std::string, cellKinds>& cellCodes() {
+    static const auto codes = [] {
+        std::array<std::string, cellKinds> result;
+        for (int name = 0; name < static_cast<int>(ColorName::Invalid); ++name) {
+            Color color(static_cast<ColorName>(name));
+            result[Framebuffer::encode(color)] = ColorFormatter::getAnsiCode(color);
+        }
+        return result;
+    }();
+    return codes;
+}
+
+const std::array<char, cellKinds>& cellGlyphs() {
+    static const auto glyphs = [] {
+        std::array<char, cellKinds> result{};
+        result[Framebuffer::emptyCell] = ' ';
+        for (int name = 0; name < static_cast<int>(ColorName::Invalid); ++name) {
+            Color color(static_cast<ColorName>(name));
+            result[Framebuffer::encode(color)] = color.getName()[0];
+        }
+        return result;
+    }();
+    return glyphs;
+}
+
+const std::string& resetCode() {
+    static const std::string code = ColorFormatter::getAnsiCode(Color(ColorName::Reset));
+    return code;
+}
+
+long long tilesSpanned(const Rect& region) {
+    return static_cast<long long>(region.right / Framebuffer::tileSize - region.left / Framebuffer::tileSize + 1) *
+           (region.bottom / Framebuffer::tileSize - region.top / Framebuffer::tileSize + 1);
+}
+
+void appendPadded(std::string& out, int value, int width) {
+    std::string digits = std::to_string(value);
+    if (static_cast<int>(digits.size()) < width) {
+        out.append(static_cast<std::size_t>(width) - digits.size(), ' ');
+    }
+    out += digits;
+}
+
+void appendBorder(std::string& out, int width, int labelWidth) {
+    out.append(static_cast<std::size_t>(labelWidth), ' ');
+    out += '+';
+    out.append(static_cast<std::size_t>(width) * 3, '-');
+    out += "+\n";
+}
+
+int digitCount(int value) {
+    int digits = 1;
+    for (; value >= 10; value /= 10) {
+        ++digits;
+    }
+    return digits;
+}
+
+void appendCursorTo(std::string& out, int line, int column) {
+    out += "\033[";
+    out += std::to_string(line);
+    out += ';';
+    out += std::to_string(column);
+    out += 'H';
+}
+
+// Terminal position of a display cell's glyph: a header line and a border line precede the rows,
+// and each row starts with a label of labelWidth characters and '|', followed by three characters per cell.
+int screenLine(int row) { return row + 3; }
+int screenColumn(int col, int labelWidth) { return col * 3 + labelWidth + 3; }
+
+// Scene writers take any range of FigureStore slots, so they serve both the live store and snapshots.
+template<typename Figures>
+Board::SaveReport writeTextScene(const std::string& filePath, const Figures& figures) {
+    std::ofstream myFile(filePath, std::ios::out);
+    if (!myFile.is_open()) {
+        return {true, "Could not open file " + filePath + " for writing."};
+    }
+    if (figures.empty()) {
+        return {false, "There are no figures. An empty file will be saved."};
+    }
+
+    for (const auto& slot : figures) {
+        const Figure& figure = slot.shape.common();
+        std::string colorName = figure.color.getName();
+        std::transform(colorName.begin(), colorName.end(), colorName.begin(), ::tolower);
+        myFile << slot.id << " "
+               << (figure.fillMode == FillMode::Fill ? "fill" : "frame") << " "
+               << colorName << " "
+               << slot.shape.getShapeType() << " "
+               << figure.x << " " << figure.y << " "
+               << slot.shape.getParam1();
+
+        if (slot.shape.getType() == ShapeType::Rectangle || slot.shape.getType() == ShapeType::Line) {
+            myFile << " " << slot.shape.getParam2();
+        }
+
+        myFile << '\n';
+    }
+    if (myFile.tellp() > 0) {
+        Profiler::countBytes(static_cast<std::size_t>(myFile.tellp()));
+    }
+    return {false, "Figures saved to " + filePath};
+}
+
+template<typename Figures>
+Board::SaveReport writeBinaryScene(const std::string& filePath, const Figures& figures, int boardWidth, int boardHeight) {
+    std::ofstream output(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output.is_open()) {
+        return {true, "Could not open file " + filePath + " for writing."};
+    }
+
+    SceneHeader header{};
+    std::copy(std::begin(SceneHeader::expectedMagic), std::end(SceneHeader::expectedMagic), header.magic);
+    header.version = SceneHeader::currentVersion;
+    header.recordSize = sizeof(SceneRecord);
+    header.boardWidth = boardWidth;
+    header.boardHeight = boardHeight;
+    header.recordCount = figures.size();
+
+    std::vector<SceneRecord> records;
+    records.reserve(figures.size());
+    for (const auto& slot : figures) {
+        records.push_back(toSceneRecord(slot.id, slot.shape));
+    }
+
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(SceneRecord)));
+    if (!output) {
+        return {true, "Failed to write file " + filePath + "."};
+    }
+    Profiler::countBytes(sizeof(header) + records.size() * sizeof(SceneRecord));
+    return {false, std::to_string(figures.size()) + " figures saved to " + filePath};
+}
+
+}
 
 void Board::print() const {
-    std::cout << "   ";
-    for (int col = 0; col < boardWidth; ++col) {
-        std::cout << std::setw(2) << col << " ";
+    frameBuffer.clear();
+    appendFrame(frameBuffer);
+    writeFrame();
+}
+
+// Fills line with display columns firstColumn..lastColumn of one display row of the viewport. At zoom 1
+// these are board cells; otherwise each shows the first non-empty cell of its block, scanning row by row.
+// Only tiles that hold something are read, so a zoomed row costs what is drawn under it, not its area.
+void Board::sampleRow(const Framebuffer& frame, int displayRow, int firstColumn, int lastColumn,
+                      std::vector<Framebuffer::Cell>& line) const {
+    Rect visible = getVisibleRect();
+    line.assign(static_cast<std::size_t>(lastColumn - firstColumn + 1), Framebuffer::emptyCell);
+    int top = visible.top + displayRow * zoom;
+    Rect band{visible.left + firstColumn * zoom, top, std::min(visible.right, visible.left + (lastColumn + 1) * zoom - 1),
+              std::min(visible.bottom, top + zoom - 1)};
+
+    std::vector<const Framebuffer::Tile*> tiles;
+    frame.findTiles(band, tiles);
+    if (zoom == 1) {
+        for (const Framebuffer::Tile* tile : tiles) {
+            Rect area = tile->area.intersected(band);
+            for (int col = area.left; col <= area.right; ++col) {
+                line[static_cast<std::size_t>(col - band.left)] = tile->at(col, top);
+            }
+        }
+        return;
     }
-    std::cout << "\n";
 
-    std::cout << "  +";
-    for (int col = 0; col < boardWidth; ++col) {
-        std::cout << "---";
+    // Tiles come in no particular order, so each display cell keeps the position of the cell it shows.
+    std::vector<std::pair<int, int>> shownAt(line.size(), {std::numeric_limits<int>::max(), 0});
+    for (const Framebuffer::Tile* tile : tiles) {
+        Rect area = tile->area.intersected(band);
+        for (int row = area.top; row <= area.bottom; ++row) {
+            for (int col = area.left; col <= area.right; ++col) {
+                Framebuffer::Cell cell = tile->at(col, row);
+                auto index = static_cast<std::size_t>((col - visible.left) / zoom - firstColumn);
+                if (cell != Framebuffer::emptyCell && std::make_pair(row, col) < shownAt[index]) {
+                    line[index] = cell;
+                    shownAt[index] = {row, col};
+                }
+            }
+        }
     }
-    std::cout << "+\n";
+}
 
-    for (int row = 0; row < boardHeight; ++row) {
-        std::cout << std::setw(2) << row << "|";
-        for (const std::string& c : grid[row]) {
-            std::cout << " " << c << " ";
+// A color code is only emitted when the color changes along a row, so a run of same-colored cells
+// shares a single escape sequence.
+void Board::appendFrame(std::string& out) const {
+    const auto& codes = cellCodes();
+    const auto& glyphs = cellGlyphs();
+    Rect visible = getVisibleRect();
+    int columns = displayColumns();
+    int width = labelWidth();
+
+    // Each column label ends above its glyph; labels wider than two digits go on every step-th column only.
+    int step = (width + 3) / 3;
+    std::size_t header = out.size();
+    out.append(static_cast<std::size_t>(width + 1 + columns * 3), ' ');
+    for (int col = 0; col < columns; col += step) {
+        std::string label = std::to_string(visible.left + col * zoom);
+        std::size_t end = header + static_cast<std::size_t>(width + col * 3 + 3);
+        out.replace(end - label.size(), label.size(), label);
+    }
+    out += '\n';
+    appendBorder(out, columns, width);
+
+    std::vector<Framebuffer::Cell> line;
+    for (int row = 0; row < displayRows(); ++row) {
+        appendPadded(out, visible.top + row * zoom, width);
+        out += '|';
+        sampleRow(grid, row, 0, columns - 1, line);
+        Framebuffer::Cell active = Framebuffer::emptyCell;
+        for (Framebuffer::Cell cell : line) {
+            if (cell != Framebuffer::emptyCell && cell != active) {
+                out += codes[cell];
+                active = cell;
+            }
+            out += ' ';
+            out += glyphs[cell];
+            out += ' ';
         }
-        std::cout << "|\n";
+        if (active != Framebuffer::emptyCell) {
+            out += resetCode();
+        }
+        out += "|\n";
     }
+    appendBorder(out, columns, width);
+}
 
-    std::cout << "  +";
-    for (int col = 0; col < boardWidth; ++col) {
-        std::cout << "---";
+// Row labels, and the left margin that holds them, are as wide as the largest coordinate shown, and at least two digits.
+int Board::labelWidth() const {
+    Rect visible = getVisibleRect();
+    int lastColumn = visible.left + (displayColumns() - 1) * zoom;
+    int lastRow = visible.top + (displayRows() - 1) * zoom;
+    return std::max(2, digitCount(std::max(lastColumn, lastRow)));
+}
+
+bool Board::isPrintable() const {
+    return static_cast<long long>(displayColumns()) * displayRows() <= maxPrintedCells;
+}
+
+void Board::reportUnprintable(std::ostream& stream) const {
+    stream << "The view is " << displayColumns() << "x" << displayRows() << " cells, more than the " << maxPrintedCells
+           << " that can be printed. Use viewport to show a smaller window or a larger zoom.\n";
+}
+
+std::ostream& Board::out() const {
+    return *output;
+}
+
+std::ostream& Board::message() const {
+    static std::ostream discard(nullptr);
+    return quiet ? discard : *output;
+}
+
+std::ostream& Board::error() const {
+    ++errorCount;
+    if (errorLine != 0) {
+        *errorOutput << "line " << errorLine << ": ";
     }
-    std::cout << "+\n";
+    return *errorOutput;
+}
+
+void Board::setOutput(std::ostream& stream, std::ostream& errorStream) {
+    output = &stream;
+    errorOutput = &errorStream;
+}
+
+void Board::setSaveListener(SaveListener listener) {
+    saveListener = std::move(listener);
+}
+
+void Board::setQuiet(bool suppressMessages) {
+    quiet = suppressMessages;
 }
 
-std::vector<std::shared_ptr<Figure>> Board::getFigures() const {
-    std::vector<std::shared_ptr<Figure>> result;
-    result.reserve(figures.size());
-for (const auto& figurePair : figures) {
-        result.push_back(figurePair.second);
+void Board::setErrorLine(std::size_t line) {
+    errorLine = line;
+}
+
+void Board::writeFrame() const {
+    out().write(frameBuffer.data(), static_cast<std::streamsize>(frameBuffer.size()));
+    Profiler::countBytes(frameBuffer.size());
+}
+
+// In incremental mode the board is pinned to the top of the screen and everything else scrolls in a
+// region below it, so later draws can rewrite individual cells in place.
+void Board::present(const std::vector<Rect>& changed, bool repaint) {
+    if (displayMode == DisplayMode::Full) {
+        print();
+        return;
     }
-    return result;
+    if (shownValid && !repaint) {
+        printChanges(changed);
+        return;
+    }
+
+    frameBuffer.assign("\033[r\033[2J\033[H");
+    appendFrame(frameBuffer);
+    shownLabelWidth = labelWidth();
+    int promptLine = screenLine(displayRows()) + 1;
+    frameBuffer += "\033[" + std::to_string(promptLine) + "r";
+    appendCursorTo(frameBuffer, promptLine, 1);
+    writeFrame();
+    shownFrame = grid;
+    shownValid = true;
+}
+
+// Only display cells that differ from the last frame sent are written, one cursor move per run of changed
+// cells. All regions are compared against the old frame before any of it is updated, since a zoomed
+// display cell can span several regions.
+void Board::printChanges(const std::vector<Rect>& changed) {
+    const auto& codes = cellCodes();
+    const auto& glyphs = cellGlyphs();
+    Rect visible = getVisibleRect();
+
+    frameBuffer.assign("\0337");
+    std::size_t header = frameBuffer.size();
+    std::vector<Framebuffer::Cell> cells, before;
+    for (const Rect& region : changed) {
+        Rect area = region.intersected(visible);
+        if (area.empty()) {
+            continue;
+        }
+        int firstColumn = (area.left - visible.left) / zoom;
+        int lastColumn = (area.right - visible.left) / zoom;
+        for (int row = (area.top - visible.top) / zoom; row <= (area.bottom - visible.top) / zoom; ++row) {
+            sampleRow(grid, row, firstColumn, lastColumn, cells);
+            sampleRow(shownFrame, row, firstColumn, lastColumn, before);
+            Framebuffer::Cell active = Framebuffer::emptyCell;
+            bool inRun = false;
+            for (std::size_t i = 0; i < cells.size(); ++i) {
+                Framebuffer::Cell cell = cells[i];
+                if (cell == before[i]) {
+                    inRun = false;
+                    continue;
+                }
+                if (inRun) {
+                    frameBuffer += "  ";
+                }
+                else {
+                    appendCursorTo(frameBuffer, screenLine(row), screenColumn(firstColumn + static_cast<int>(i), shownLabelWidth));
+                    inRun = true;
+                }
+                if (cell != Framebuffer::emptyCell && cell != active) {
+                    frameBuffer += codes[cell];
+                    active = cell;
+                }
+                frameBuffer += glyphs[cell];
+            }
+            if (active != Framebuffer::emptyCell) {
+                frameBuffer += resetCode();
+            }
+        }
+    }
+    for (const Rect& region : changed) {
+        shownFrame.copyTile(grid, region.left, region.top);
+    }
+
+    if (frameBuffer.size() > header) {
+        frameBuffer += "\0338";
+        writeFrame();
+    }
+}
+
+void Board::setDisplayMode(DisplayMode mode) {
+    if (displayMode == DisplayMode::Incremental && mode != DisplayMode::Incremental) {
+        out() << "\0337\033[r\0338";
+    }
+    displayMode = mode;
+    shownValid = false;
+    shownFrame.clear();
+    message() << "Display mode set to " << (mode == DisplayMode::Incremental ? "incremental" : "full") << ".\n";
+}
+
+Board::~Board() {
+    if (displayMode == DisplayMode::Incremental) {
+        out() << "\0337\033[r\0338" << std::flush;
+    }
+}
+
+const FigureStore& Board::getFigures() const {
+    return figures;
 }
 
 void Board::add(ShapeType shapeType, ColorName colorName, int x, int y, int param1, int param2, FillMode fillMode) {
     if (colorName == ColorName::Invalid) {
-        std::cout << "Invalid color." << std::endl;
+        error() << "Invalid color.\n";
         return;
     }
     Color color(colorName);
-    std::shared_ptr<Figure> newFigure = nullptr;
 
-    switch (shapeType) {
-        case ShapeType::Triangle:
-            newFigure = std::make_shared<Triangle>(x, y, param1, color, fillMode);
-            break;
-        case ShapeType::Rectangle:
-            newFigure = std::make_shared<Rectangle>(x, y, param1, param2, color, fillMode);
-            break;
-        case ShapeType::Circle:
-            newFigure = std::make_shared<Circle>(x, y, param1, color, fillMode);
-            break;
-        case ShapeType::Line:
-            newFigure = std::make_shared<Line>(x, y, param1, param2, color, fillMode);
-            break;
-        default:
-            std::cout << "Invalid shape type." << std::endl;
-            return;
+    if (shapeType == ShapeType::Invalid) {
+        error() << "Invalid shape type.\n";
+        return;
     }
+    if (shapeType == ShapeType::Triangle || shapeType == ShapeType::Circle) {
+        param2 = 0;
+    }
+    Shape newFigure = Shape::create(shapeType, x, y, param1, param2, color, fillMode);
 
     if (isDuplicate(newFigure)) {
-        std::cout << "Error: Figure with the same parameters already exists at the same position!" << std::endl;
+        error() << "Error: Figure with the same parameters already exists at the same position!\n";
         return;
     }
-    else if (newFigure->isOutOfBounds(boardWidth, boardHeight)) {
-        std::cout << "Error: Figure is too large to fit on the board and cannot be added." << std::endl;
+    else if (newFigure.isOutOfBounds(boardWidth, boardHeight)) {
+        error() << "Error: Figure is too large to fit on the board and cannot be added.\n";
         return;
     }
     else {
-        figures.emplace_back(shapeIDCounter, newFigure);
-        std::cout << "[" << shapeIDCounter << "] " << newFigure->getShapeType() << " " << color.getName()
+        figures.insert(shapeIDCounter, newFigure);
+        addFigureKey(newFigure);
+        spatialIndex.insert(shapeIDCounter, newFigure.getBounds());
+        markDirty(newFigure.getBounds());
+        recordChange({Change::Type::Add, "add", shapeIDCounter, figures.sequenceOf(shapeIDCounter), std::nullopt, newFigure, std::nullopt});
+        message() << "[" << shapeIDCounter << "] " << newFigure.getShapeType() << " " << color.getName()
                   << " " << x << " " << y << " " << param1;
 
         if (shapeType == ShapeType::Rectangle || shapeType == ShapeType::Line) {
-            std::cout << " " << param2;
+            message() << " " << param2;
         }
-        std::cout << std::endl;
+        message() << '\n';
         ++shapeIDCounter;
     }
 }
 
+// Applies edits in order with the checks add, move and paint make, paying for the bookkeeping once per
+// batch: the tables grow once, each add finds its key with a single lookup for both the duplicate check and
+// the insert, the regions to redraw are merged at the end, and the journal gets one append. Every edit can
+// still be undone on its own. Nothing is printed; the outcome counts what was rejected.
+Board::BatchOutcome Board::applyBatch(const std::vector<Operation>& operations) {
+    BatchOutcome outcome;
+    auto adds = static_cast<std::size_t>(std::count_if(operations.begin(), operations.end(), [](const Operation& operation) {
+        return operation.type == Operation::Type::Add;
+    }));
+    figures.reserve(figures.size() + adds);
+    figureKeys.reserve(figureKeys.size() + adds);
+
+    std::vector<Rect> dirty;
+    dirty.reserve(operations.size() * 2);
+    std::vector<JournalRecord> records;
+    for (const Operation& operation : operations) {
+        std::optional<Change> change;
+        if (operation.type == Operation::Type::Add) {
+            if (operation.color == ColorName::Invalid || operation.shapeType == ShapeType::Invalid) {
+                ++outcome.invalid;
+                continue;
+            }
+            bool usesParam2 = operation.shapeType == ShapeType::Rectangle || operation.shapeType == ShapeType::Line;
+            Shape shape = Shape::create(operation.shapeType, operation.x, operation.y, operation.param1, usesParam2 ? operation.param2 : 0,
+                                        Color(operation.color), operation.fillMode);
+            auto [key, inserted] = figureKeys.try_emplace(shape.getKey(), 1);
+            if (!inserted) {
+                ++outcome.duplicates;
+                continue;
+            }
+            if (shape.isOutOfBounds(boardWidth, boardHeight)) {
+                figureKeys.erase(key);
+                ++outcome.outOfBounds;
+                continue;
+            }
+            int id = shapeIDCounter++;
+            figures.insert(id, shape);
+            spatialIndex.insert(id, shape.getBounds());
+            dirty.push_back(shape.getBounds());
+            change = Change{Change::Type::Add, "add", id, figures.sequenceOf(id), std::nullopt, shape, std::nullopt};
+        }
+        else {
+            if (operation.type == Operation::Type::Paint && operation.color == ColorName::Invalid) {
+                ++outcome.invalid;
+                continue;
+            }
+            Shape* figure = figures.modify(operation.id);
+            if (figure == nullptr) {
+                ++outcome.missing;
+                continue;
+            }
+            bool moving = operation.type == Operation::Type::Move;
+            change = Change{Change::Type::Update, moving ? "move" : "paint", operation.id, 0, *figure, std::nullopt, std::nullopt};
+            removeFigureKey(*figure);
+            if (moving) {
+                dirty.push_back(figure->getBounds());
+                figure->common().x = operation.x;
+                figure->common().y = operation.y;
+                if (figure->getType() == ShapeType::Line) {
+                    footprints.erase(operation.id);
+                }
+                spatialIndex.update(operation.id, figure->getBounds());
+            }
+            else {
+                figure->common().color = Color(operation.color);
+            }
+            addFigureKey(*figure);
+            dirty.push_back(figure->getBounds());
+            change->after = *figure;
+        }
+
+        if (journal.isOpen()) {
+            std::vector<JournalRecord> changeRecords = journalRecords(*change, true);
+            records.insert(records.end(), changeRecords.begin(), changeRecords.end());
+        }
+        rememberChange(std::move(*change));
+        ++outcome.applied;
+    }
+
+    // Past the region limit markDirty would merge everything into one rectangle anyway, so do it in one go.
+    if (dirty.size() > maxDirtyRegions) {
+        Rect merged;
+        for (const Rect& region : dirty) {
+            merged = merged.united(region.intersected(getBoardRect()));
+        }
+        dirty.assign(1, merged);
+    }
+    for (const Rect& region : dirty) {
+        markDirty(region);
+    }
+    if (!records.empty()) {
+        writeJournal(records);
+    }
+    return outcome;
+}
+
+// Chunks of the file are parsed and checked in parallel, then duplicate figures and IDs are looked for in
+// parallel over hash partitions. The earliest problem in file order decides the outcome, exactly as if the
+// file had been read line by line: an unreadable line ends the data, any other error aborts the load.
 void Board::load(const std::string& filePath) {
-    std::ifstream input(filePath, std::ios::in);
-    if (!input.is_open()) {
-        std::cout << "Could not open file " << filePath << " for reading." << std::endl;
+    finishBackgroundSave();
+    Profiler::Scope phase(profiler, "load", "read");
+    MappedFile file(filePath);
+    if (!file.isOpen()) {
+        error() << "Could not open file " << filePath << " for reading.\n";
         return;
     }
-
-    if (input.peek() == std::ifstream::traits_type::eof()) {
-        std::cout << "The file " << filePath << " is empty. Nothing to load." << std::endl;
-        input.close();
+    if (file.readError()) {
+        error() << "Could not read file " << filePath << ": " << file.readError().message() << ".\n";
+        return;
+    }
+    if (file.size() == 0) {
+        error() << "The file " << filePath << " is empty. Nothing to load.\n";
         return;
     }
 
-    std::vector<std::pair<int, std::shared_ptr<Figure>>> tempFigures;
-    std::vector<std::vector<std::string>> tempGrid = grid;
-    grid.assign(boardHeight, std::vector<std::string>(boardWidth, " "));
-
-    int id, x, y, param1, param2;
-    std::string fillModeStr, colorStr, shapeTypeStr;
-    bool loadSuccessful = true;
-
-    while (input >> id >> fillModeStr >> colorStr >> shapeTypeStr >> x >> y >> param1) {
-        FillMode fillMode = (fillModeStr == "fill") ? FillMode::Fill : FillMode::Frame;
+    phase.next("parse");
+    ThreadPool& pool = threadPool();
+    std::vector<std::string_view> chunks = splitAtLines({file.data(), file.size()}, pool.size() * 4);
+    std::vector<std::vector<ParsedFigure>> parsed(chunks.size());
+    pool.parallelFor(chunks.size(), [&](std::size_t chunk) {
+        parseSceneLines(chunks[chunk], boardWidth, boardHeight, parsed[chunk]);
+    });
 
-        ColorName colorName = Color::fromString(colorStr);
-        if (colorName == ColorName::Invalid) {
-            std::cout << "Invalid color specified: " << colorStr << std::endl;
-            loadSuccessful = false;
+    std::vector<ParsedFigure> records;
+    std::size_t total = 0;
+    for (const auto& chunk : parsed) {
+        total += chunk.size();
+    }
+    records.reserve(total);
+    for (auto& chunk : parsed) {
+        records.insert(records.end(), chunk.begin(), chunk.end());
+        bool stopped = !chunk.empty() && chunk.back().status != ParsedFigure::Status::Ok;
+        chunk = {};
+        if (stopped) {
             break;
         }
-        Color color(colorName);
+    }
 
-        auto shapeTypeIt = shapeTypeMap.find(shapeTypeStr);
-        if (shapeTypeIt == shapeTypeMap.end()) {
-            std::cout << "Error: Invalid shape type " << shapeTypeStr << " found in file. Aborting load." << std::endl;
-            loadSuccessful = false;
-            break;
+    std::size_t end = records.size();
+    std::size_t firstError = end;
+    if (!records.empty() && records.back().status != ParsedFigure::Status::Ok) {
+        if (records.back().status == ParsedFigure::Status::Malformed) {
+            end = records.size() - 1;
         }
-        ShapeType shapeType = shapeTypeIt->second;
+        firstError = records.size() - 1;
+    }
 
-        std::shared_ptr<Figure> newFigure = nullptr;
+    phase.next("validate");
+    // Slices of the records are dealt out to the partitions in parallel, then each partition checks its share
+    // slice by slice, so it sees its records in file order and every record is looked at once.
+    std::size_t partitions = pool.size();
+    std::size_t checked = std::min(end, firstError);
+    std::size_t sliceSize = checked / partitions + 1;
+    std::vector<std::vector<std::vector<std::size_t>>> keyShares(partitions, std::vector<std::vector<std::size_t>>(partitions));
+    std::vector<std::vector<std::vector<std::size_t>>> idShares = keyShares;
+    pool.parallelFor(partitions, [&](std::size_t slice) {
+        FigureKeyHash keyHash;
+        for (std::size_t i = slice * sliceSize; i < std::min(checked, (slice + 1) * sliceSize); ++i) {
+            keyShares[slice][keyHash(records[i].key) % partitions].push_back(i);
+            idShares[slice][static_cast<std::size_t>(records[i].id) % partitions].push_back(i);
+        }
+    });
 
-        switch (shapeType) {
-            case ShapeType::Triangle:
-                newFigure = std::make_shared<Triangle>(x, y, param1, color, fillMode);
-                break;
-            case ShapeType::Rectangle:
-                if (!(input >> param2)) {
-                    std::cout << "Missing parameters for shape " << shapeTypeStr << std::endl;
-                    loadSuccessful = false;
+    std::vector<std::size_t> duplicateFigure(partitions, end);
+    std::vector<std::size_t> duplicateID(partitions, end);
+    pool.parallelFor(partitions, [&](std::size_t partition) {
+        std::unordered_set<FigureKey, FigureKeyHash> keys;
+        for (std::size_t slice = 0; slice < partitions && duplicateFigure[partition] == end; ++slice) {
+            for (std::size_t i : keyShares[slice][partition]) {
+                if (!keys.insert(records[i].key).second) {
+                    duplicateFigure[partition] = i;
                     break;
                 }
-                newFigure = std::make_shared<Rectangle>(x, y, param1, param2, color, fillMode);
-                break;
-            case ShapeType::Circle:
-                if (param1 <= 0) {
-                    std::cout << "Invalid radius for circle." << std::endl;
-                    loadSuccessful = false;
-                    break;
-                }
-                newFigure = std::make_shared<Circle>(x, y, param1, color, fillMode);
-                break;
-            case ShapeType::Line:
-                if (!(input >> param2)) {
-                    std::cout << "Missing parameters for shape " << shapeTypeStr << std::endl;
-                    loadSuccessful = false;
+            }
+        }
+        std::unordered_set<int> ids;
+        for (std::size_t slice = 0; slice < partitions && duplicateID[partition] == end; ++slice) {
+            for (std::size_t i : idShares[slice][partition]) {
+                if (!ids.insert(records[i].id).second) {
+                    duplicateID[partition] = i;
                     break;
                 }
-                newFigure = std::make_shared<Line>(x, y, param1, param2, color, fillMode);
-                break;
-            default:
-                std::cout << "Invalid shape type in file." << std::endl;
-                loadSuccessful = false;
-                break;
+            }
         }
+    });
 
-        if (!loadSuccessful) {
-            break;
+    std::string failure;
+    std::size_t errorIndex = firstError < end ? firstError : end;
+    if (errorIndex < end) {
+        failure = records[errorIndex].describeError();
+    }
+    std::size_t firstDuplicateFigure = *std::min_element(duplicateFigure.begin(), duplicateFigure.end());
+    if (firstDuplicateFigure < errorIndex) {
+        errorIndex = firstDuplicateFigure;
+        failure = "Error: Duplicate figure found.";
+    }
+    std::size_t firstDuplicateID = *std::min_element(duplicateID.begin(), duplicateID.end());
+    if (firstDuplicateID < errorIndex) {
+        errorIndex = firstDuplicateID;
+        failure = "Error: Duplicate figure ID " + std::to_string(records[firstDuplicateID].id) + " found.";
+    }
+
+    for (std::size_t i = 0; i < std::min(errorIndex, end); ++i) {
+        shapeIDCounter = std::max(shapeIDCounter, records[i].id + 1);
+    }
+    if (errorIndex < end) {
+        error() << failure << '\n';
+        error() << "Failed to load file. Board was not modified.\n";
+        return;
+    }
+
+    figures.clear();
+    footprints.clear();
+    figures.reserve(end);
+    figureKeys.clear();
+    figureKeys.reserve(end);
+    for (std::size_t i = 0; i < end; ++i) {
+        figures.insert(records[i].id, records[i].toShape());
+        figureKeys.emplace(records[i].key, 1);
+    }
+    selectedID = -1;
+    rebuildSpatialIndex();
+    markAllDirty();
+    resetHistory();
+    message() << "Figures loaded successfully from " << filePath << '\n';
+}
+
+// Shared by every board in the process, so a server holding many boards still runs one worker per core.
+ThreadPool& Board::threadPool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+
+bool Board::isDuplicate(const Shape& figure) const {
+    return figureKeys.find(figure.getKey()) != figureKeys.end();
+}
+
+void Board::addFigureKey(const Shape& figure) {
+    ++figureKeys[figure.getKey()];
+}
+
+void Board::removeFigureKey(const Shape& figure) {
+    auto it = figureKeys.find(figure.getKey());
+    if (it != figureKeys.end() && --it->second == 0) {
+        figureKeys.erase(it);
+    }
+}
+
+void Board::draw() {
+    if (!isPrintable()) {
+        reportUnprintable(error());
+        shownValid = false;
+        return;
+    }
+    bool repaint = fullRedraw;
+    std::vector<Rect> changed;
+    if (!render(changed)) {
+        reportUnrenderable(error());
+        shownValid = false;
+        return;
+    }
+    Profiler::Scope phase(profiler, "draw", "print");
+    present(changed, repaint);
+}
+
+// Brings the grid up to date and stores the tile pieces it redrew in tiles, without printing anything. Returns false,
+// leaving the grid as it was and still stale, when the grid would need more than maxRenderedTiles tiles.
+bool Board::render(std::vector<Rect>& tiles) {
+    Profiler::Scope phase(profiler, "draw", "clear");
+    // One job per tile: pieces of different regions that land on the same tile are merged so no job overwrites another.
+    tiles.clear();
+    std::unordered_map<std::int64_t, std::size_t> tileJobs;
+    // Only the viewport is kept up to date; changing it forces a full redraw of the new window. Jobs for a large
+    // region come from the tiles the figures in it draw on and the tiles already drawn there, so its empty area
+    // costs nothing.
+    Rect visible = getVisibleRect();
+    std::vector<const Framebuffer::Tile*> drawn;
+    auto collectRegion = [&](const Rect& region, bool redrawsTiles) {
+        if (region.empty()) {
+            return;
+        }
+        if (tilesSpanned(region) <= smallRegionTiles) {
+            collectTiles(region, tiles, tileJobs);
+            return;
+        }
+        if (redrawsTiles) {
+            grid.findTiles(region, drawn);
+            for (const Framebuffer::Tile* tile : drawn) {
+                collectTiles(tile->area.intersected(region), tiles, tileJobs);
+            }
+        }
+        for (int id : spatialIndex.query(region)) {
+            collectFigureTiles(id, region, tiles, tileJobs);
+        }
+    };
+    if (fullRedraw) {
+        if (viewport.empty()) {
+            for (const auto& slot : figures) {
+                collectFigureTiles(slot.id, visible, tiles, tileJobs);
+            }
         }
+        else {
+            collectRegion(visible, false);
+        }
+    }
+    else {
+        for (const Rect& region : dirtyRegions) {
+            collectRegion(region.intersected(visible), true);
+        }
+    }
 
-        if (newFigure->isOutOfBounds(boardWidth, boardHeight)) {
-            std::cout << "Error: Figure is out of bounds." << std::endl;
-            loadSuccessful = false;
-            break;
+    // Collection stops once the jobs alone pass the budget. Otherwise the tiles kept from earlier draws count too.
+    std::size_t needed = fullRedraw ? tiles.size() : grid.allocatedTiles();
+    if (!fullRedraw) {
+        for (const Rect& tile : tiles) {
+            needed += grid.findTile(tile.left, tile.top) == nullptr ? 1 : 0;
         }
+    }
+    if (tiles.size() > maxRenderedTiles || needed > maxRenderedTiles) {
+        tiles.clear();
+        return false;
+    }
+    if (fullRedraw) {
+        grid.clear();
+        fullRedraw = false;
+    }
+    dirtyRegions.clear();
 
-        if (!isDuplicate(newFigure)) {
-            tempFigures.emplace_back(id, newFigure);
+    auto forEachTile = [this, &tiles](const std::function<void(std::size_t)>& body) {
+        if (tiles.size() > 1) {
+            threadPool().parallelFor(tiles.size(), body);
         }
-        else {
-            std::cout << "Error: Duplicate figure found." << std::endl;
-            loadSuccessful = false;
-            break;
+        else if (!tiles.empty()) {
+            body(0);
         }
+    };
 
-        shapeIDCounter = std::max(shapeIDCounter, id + 1);
+    phase.next("rasterize");
+    std::vector<std::vector<int>> tileFigures(tiles.size());
+    forEachTile([this, &tiles, &tileFigures](std::size_t index) {
+        tileFigures[index] = spatialIndex.query(tiles[index]);
+        sortByDrawOrder(tileFigures[index]);
+    });
+    cacheFootprints(tileFigures);
+
+    std::vector<std::unique_ptr<Framebuffer::Tile>> rendered(tiles.size());
+    forEachTile([this, &tiles, &tileFigures, &rendered](std::size_t index) {
+        const Rect& region = tiles[index];
+        const Framebuffer::Tile* existing = grid.findTile(region.left, region.top);
+        if (tileFigures[index].empty() && existing == nullptr) {
+            return;
+        }
+
+        // Drawn on the stack first, so a tile the figures found here leave blank is never allocated.
+        Framebuffer::Tile tile = existing != nullptr ? *existing : Framebuffer::Tile(Framebuffer::tileArea(region.left, region.top));
+        tile.clear(region);
+        cullOccluded(tileFigures[index], region);
+        for (int id : tileFigures[index]) {
+            drawFigure(id, tile, region);
+        }
+        if (!tile.empty()) {
+            rendered[index] = std::make_unique<Framebuffer::Tile>(tile);
+        }
+    });
+
+    for (std::size_t i = 0; i < tiles.size(); ++i) {
+        grid.storeTile(tiles[i].left, tiles[i].top, std::move(rendered[i]));
     }
+    return true;
+}
 
-    input.close();
+void Board::reportUnrenderable(std::ostream& stream) const {
+    stream << "Drawing the view would take more than " << maxRenderedTiles << " tiles of " << Framebuffer::tileSize << "x"
+           << Framebuffer::tileSize << " cells. Use viewport to show a smaller window.\n";
+}
 
-    if (loadSuccessful) {
-        figures.swap(tempFigures);
-        std::cout << "Figures loaded successfully from " << filePath << std::endl;
+template<typename Target>
+void Board::drawFigure(int id, Target& target, const Rect& clip) const {
+    const Shape* figure = figures.find(id);
+    auto cached = footprints.find(id);
+    if (cached != footprints.end()) {
+        cached->second.draw(target, clip, figure->common().x, figure->common().y, Framebuffer::encode(figure->common().color));
     }
     else {
-        std::cout << "Failed to load file. Board was not modified." << std::endl;
+        figure->draw(target, clip);
     }
 }
 
+// Drops figures, in draw order, whose visible part of the region is painted over by later filled figures.
+// Walking back to front, each kept filled figure adds its cells to the coverage the earlier ones are tested against.
+void Board::cullOccluded(std::vector<int>& ids, const Rect& region) const {
+    Coverage coverage(Framebuffer::tileArea(region.left, region.top));
+    std::size_t kept = ids.size();
+    for (std::size_t i = ids.size(); i-- > 0;) {
+        const Shape* figure = figures.find(ids[i]);
+        Rect visible = figure->getBounds().intersected(region);
+        if (visible.empty() || coverage.covers(visible)) {
+            continue;
+        }
+        ids[--kept] = ids[i];
+        if (figure->common().fillMode == FillMode::Fill && figure->getType() != ShapeType::Line) {
+            drawFigure(ids[i], coverage, visible);
+        }
+    }
+    ids.erase(ids.begin(), ids.begin() + static_cast<std::ptrdiff_t>(kept));
+}
 
-bool Board::isDuplicate(const std::shared_ptr<Figure>& figure) const {
-    for (const auto& existingFigure : figures) {
-        if (figure->getShapeType() == existingFigure.second->getShapeType() &&
-            figure->x == existingFigure.second->x &&
-            figure->y == existingFigure.second->y &&
-            figure->getParam1() == existingFigure.second->getParam1() &&
-            figure->getParam2() == existingFigure.second->getParam2() &&
-            figure->color.getName() == existingFigure.second->color.getName() &&
-            figure->fillMode == existingFigure.second->fillMode) {
-            return true;
+// Builds footprints for the figures about to be drawn that do not have one yet. Entries are created
+// serially so the parallel builds and the rasterizer only ever read the map.
+void Board::cacheFootprints(const std::vector<std::vector<int>>& tileFigures) {
+    std::vector<std::pair<const Shape*, Footprint*>> missing;
+    for (const auto& ids : tileFigures) {
+        for (int id : ids) {
+            const Shape* figure = figures.find(id);
+            if (footprints.count(id) == 0 && Footprint::fits(*figure)) {
+                missing.emplace_back(figure, &footprints[id]);
+            }
         }
     }
-    return false;
+
+    if (missing.size() > 1) {
+        threadPool().parallelFor(missing.size(), [&missing](std::size_t index) { missing[index].second->build(*missing[index].first); });
+    }
+    else if (!missing.empty()) {
+        missing[0].second->build(*missing[0].first);
+    }
 }
 
-void Board::draw() {
-    grid.assign(boardHeight, std::vector<std::string>(boardWidth, " "));
+void Board::collectTiles(const Rect& region, std::vector<Rect>& tiles, std::unordered_map<std::int64_t, std::size_t>& tileJobs) const {
+    if (region.empty()) {
+        return;
+    }
+    for (int top = Framebuffer::tileArea(0, region.top).top; top <= region.bottom; top += Framebuffer::tileSize) {
+        for (int left = Framebuffer::tileArea(region.left, 0).left; left <= region.right; left += Framebuffer::tileSize) {
+            Rect piece = region.intersected(Framebuffer::tileArea(left, top));
+            auto [it, inserted] = tileJobs.try_emplace(static_cast<std::int64_t>(left) << 32 | top, tiles.size());
+            if (inserted) {
+                tiles.push_back(piece);
+            }
+            else {
+                tiles[it->second] = tiles[it->second].united(piece);
+            }
+        }
+    }
+}
+
+// Queues only the tiles the figure draws on inside region, found by rasterizing it into a TileSet, so an outline
+// or a line costs what it draws rather than its bounds. Figures spanning few tiles queue their bounds directly.
+void Board::collectFigureTiles(int id, const Rect& region, std::vector<Rect>& tiles, std::unordered_map<std::int64_t, std::size_t>& tileJobs) const {
+    if (tiles.size() > maxRenderedTiles) {
+        return;
+    }
+    Rect clip = figures.find(id)->getBounds().intersected(region);
+    if (clip.empty() || tilesSpanned(clip) <= smallRegionTiles) {
+        collectTiles(clip, tiles, tileJobs);
+        return;
+    }
+    TileSet touched(clip);
+    drawFigure(id, touched, clip);
+    touched.forEach([&](int left, int top) {
+        collectTiles(clip.intersected(Framebuffer::tileArea(left, top)), tiles, tileJobs);
+        return tiles.size() <= maxRenderedTiles;
+    });
+}
+
+std::vector<int> Board::figuresAt(int x, int y) const {
+    std::vector<int> result;
+    for (int id : spatialIndex.query(x, y)) {
+        if (figures.find(id)->covers(x, y)) {
+            result.push_back(id);
+        }
+    }
+    sortByDrawOrder(result);
+    return result;
+}
+
+void Board::sortByDrawOrder(std::vector<int>& ids) const {
+    std::sort(ids.begin(), ids.end(), [this](int a, int b) {
+        return figures.orderOf(a) < figures.orderOf(b);
+    });
+}
+
+void Board::rebuildSpatialIndex() {
+    spatialIndex.clear();
+    for (const auto& slot : figures) {
+        spatialIndex.insert(slot.id, slot.shape.getBounds());
+    }
+}
+
+Rect Board::getBoardRect() const {
+    return {0, 0, boardWidth - 1, boardHeight - 1};
+}
+
+Rect Board::getVisibleRect() const {
+    return viewport.empty() ? getBoardRect() : viewport.intersected(getBoardRect());
+}
+
+int Board::displayColumns() const {
+    Rect visible = getVisibleRect();
+    return (visible.right - visible.left) / zoom + 1;
+}
+
+int Board::displayRows() const {
+    Rect visible = getVisibleRect();
+    return (visible.bottom - visible.top) / zoom + 1;
+}
+
+void Board::setViewport(int x, int y, int width, int height, int zoomFactor) {
+    if (x < 0 || x >= boardWidth || y < 0 || y >= boardHeight) {
+        error() << "Viewport origin must lie on the board.\n";
+        return;
+    }
+    if (width <= 0 || height <= 0 || width > maxBoardSize || height > maxBoardSize || zoomFactor <= 0 || zoomFactor > maxBoardSize) {
+        error() << "Invalid viewport size. Width, height and zoom must be between 1 and " << maxBoardSize << ".\n";
+        return;
+    }
+
+    viewport = {x, y, x + width - 1, y + height - 1};
+    zoom = zoomFactor;
+    markAllDirty();
+    message() << "Viewport set to " << width << "x" << height << " at (" << x << ", " << y << "), zoom " << zoom << ".\n";
+}
+
+void Board::resetViewport() {
+    viewport = Rect{};
+    zoom = 1;
+    markAllDirty();
+    message() << "Viewport reset to the whole board.\n";
+}
+
+// A viewport that a size change left entirely off the board falls back to the whole board.
+void Board::fitViewport() {
+    if (!viewport.empty() && !viewport.intersects(getBoardRect())) {
+        resetViewport();
+    }
+}
+
+void Board::markDirty(const Rect& region) {
+    Rect pending = region.intersected(getBoardRect());
+    if (fullRedraw || pending.empty()) {
+        return;
+    }
 
-    for (const std::shared_ptr<Figure>& figure : getFigures()) {
-        figure->draw(*this);
+    for (std::size_t i = 0; i < dirtyRegions.size();) {
+        if (dirtyRegions[i].intersects(pending)) {
+            pending = pending.united(dirtyRegions[i]);
+            dirtyRegions[i] = dirtyRegions.back();
+            dirtyRegions.pop_back();
+            i = 0;
+        }
+        else {
+            ++i;
+        }
+    }
+    dirtyRegions.push_back(pending);
+
+    if (dirtyRegions.size() > maxDirtyRegions) {
+        Rect merged;
+        for (const Rect& dirty : dirtyRegions) {
+            merged = merged.united(dirty);
+        }
+        dirtyRegions.assign(1, merged);
     }
-    print();
+}
+
+void Board::markAllDirty() {
+    fullRedraw = true;
+    dirtyRegions.clear();
 }
 
 void Board::list() const {
+    list(out());
+}
+
+void Board::list(std::ostream& stream) const {
     if (figures.empty()) {
-        std::cout << "There are no figures on the board." << std::endl;
+        stream << "There are no figures on the board.\n";
     }
     else {
-        std::cout << "Figures on the board:" << std::endl;
-        for (const auto& figurePair : figures) {
-            int id = figurePair.first;
-            std::shared_ptr<Figure> figure = figurePair.second;
-            if (figure != nullptr) {
-                std::cout << "[" << id << "] " << figure->getInfo()
-                          << " Color: " << figure->color.getName()
-                          << " FillMode: " << (figure->fillMode == FillMode::Fill ? "Fill" : "Frame")
-                          << std::endl;
-            }
+        stream << "Figures on the board:\n";
+        for (const auto& slot : figures) {
+            const Figure& figure = slot.shape.common();
+            stream << "[" << slot.id << "] " << slot.shape.getInfo()
+                      << " Color: " << figure.color.getName()
+                      << " FillMode: " << (figure.fillMode == FillMode::Fill ? "Fill" : "Frame")
+                      << '\n';
         }
     }
 }
 
-void Board::shapes() {
-    std::cout << "List of available shapes and their parameters for the 'add' command:" << std::endl;
-    std::cout << "> circle [x, y, radius]" << std::endl;
-    std::cout << "> rectangle [x, y, width, height]" << std::endl;
-    std::cout << "> triangle [x, y, height]" << std::endl;
-    std::cout << "> line [x1, y1, x2, y2]" << std::endl;
-    std::cout << "Available colors: Red, Green, Blue, Yellow, Cyan, Magenta, White, Reset (default)." << std::endl;
-    std::cout << "Usage Example: add fill red circle 5 5 3 - This command creates a filled red circle at position (5, 5) with a radius of 3." << std::endl;
+void Board::shapes() const {
+    out() << "List of available shapes and their parameters for the 'add' command:\n";
+    out() << "> circle [x, y, radius]\n";
+    out() << "> rectangle [x, y, width, height]\n";
+    out() << "> triangle [x, y, height]\n";
+    out() << "> line [x1, y1, x2, y2]\n";
+    out() << "Available colors: Red, Green, Blue, Yellow, Cyan, Magenta, White, Reset (default).\n";
+    out() << "Usage Example: add fill red circle 5 5 3 - This command creates a filled red circle at position (5, 5) with a radius of 3.\n";
 }
 
-//void Board::undo() {
-//    if (figures.empty()) {
-//        std::cout << "There are no figures. Undo command cannot be performed." << std::endl;
-//    }
-//    else {
-//        figures.pop_back();
-//        std::cout << "The last added figure was deleted." << std::endl;
-//    }
-//}
+void Board::undo() {
+    if (historyPosition == 0) {
+        error() << "There is nothing to undo.\n";
+        return;
+    }
+    const Change& change = history[--historyPosition];
+    applyChange(change, false);
+    message() << "Undone: " << change.command;
+    if (change.type != Change::Type::Clear) {
+        message() << " of shape [" << change.id << "]";
+    }
+    message() << ".\n";
+}
 
-void Board::save(const std::string& filePath) const {
-    std::ofstream myFile(filePath, std::ios::out);
-    if (myFile.is_open()) {
-        if (figures.empty()) {
-            std::cout << "There are no figures. An empty file will be saved." << std::endl;
-        } else {
-            for (const auto& figurePair : figures) {
-                const auto& figure = figurePair.second;
-                std::string colorName = figure->color.getName();
-                std::transform(colorName.begin(), colorName.end(), colorName.begin(), ::tolower);
-                myFile << figurePair.first << " "
-                       << (figure->fillMode == FillMode::Fill ? "fill" : "frame") << " "
-                       << colorName << " "
-                       << figure->getShapeType() << " "
-                       << figure->x << " " << figure->y << " "
-                       << figure->getParam1();
-
-                if (figure->getShapeType() == "rectangle" || figure->getShapeType() == "line") {
-                    myFile << " " << figure->getParam2();
+void Board::redo() {
+    if (historyPosition == history.size()) {
+        error() << "There is nothing to redo.\n";
+        return;
+    }
+    const Change& change = history[historyPosition++];
+    applyChange(change, true);
+    message() << "Redone: " << change.command;
+    if (change.type != Change::Type::Clear) {
+        message() << " of shape [" << change.id << "]";
+    }
+    message() << ".\n";
+}
+
+// A new command drops the changes that were undone and not redone, then goes to the journal.
+void Board::recordChange(Change change) {
+    rememberChange(std::move(change));
+    writeJournal(journalRecords(history.back(), true));
+}
+
+void Board::rememberChange(Change change) {
+    history.erase(history.begin() + static_cast<std::ptrdiff_t>(historyPosition), history.end());
+    history.push_back(std::move(change));
+    if (history.size() > maxHistory) {
+        history.pop_front();
+    }
+    historyPosition = history.size();
+}
+
+// Undo and redo touch one figure, except undoing a clear, which puts back every figure it removed.
+void Board::applyChange(const Change& change, bool forward) {
+    switch (change.type) {
+        case Change::Type::Add:
+        case Change::Type::Remove:
+            if ((change.type == Change::Type::Add) == forward) {
+                putFigure(change.id, change.type == Change::Type::Add ? *change.after : *change.before, change.sequence);
+            }
+            else {
+                dropFigure(change.id);
+            }
+            break;
+        case Change::Type::Update:
+            replaceFigure(change.id, forward ? *change.after : *change.before);
+            break;
+        case Change::Type::Clear:
+            if (forward) {
+                clearFigures();
+            }
+            else {
+                for (const auto& slot : *change.cleared) {
+                    putFigure(slot.id, slot.shape, slot.sequence);
                 }
+            }
+            break;
+    }
+    writeJournal(journalRecords(change, forward));
+}
 
-                myFile << std::endl;
+std::vector<JournalRecord> Board::journalRecords(const Change& change, bool forward) const {
+    std::vector<JournalRecord> records;
+    switch (change.type) {
+        case Change::Type::Add:
+        case Change::Type::Remove:
+            if ((change.type == Change::Type::Add) == forward) {
+                records.push_back(JournalRecord::put(change.id, change.type == Change::Type::Add ? *change.after : *change.before, change.sequence));
+            }
+            else {
+                records.push_back(JournalRecord::remove(change.id));
+            }
+            break;
+        case Change::Type::Update:
+            records.push_back(JournalRecord::update(change.id, forward ? *change.after : *change.before));
+            break;
+        case Change::Type::Clear:
+            if (forward) {
+                records.push_back(JournalRecord::clear());
             }
-            std::cout << "Figures saved to " << filePath << std::endl;
+            else {
+                records.reserve(change.cleared->size());
+                for (const auto& slot : *change.cleared) {
+                    records.push_back(JournalRecord::put(slot.id, slot.shape, slot.sequence));
+                }
+            }
+            break;
+    }
+    return records;
+}
+
+void Board::putFigure(int id, const Shape& shape, std::int64_t sequence) {
+    figures.insert(id, shape, sequence);
+    addFigureKey(shape);
+    spatialIndex.insert(id, shape.getBounds());
+    markDirty(shape.getBounds());
+}
+
+void Board::dropFigure(int id) {
+    const Shape* figure = figures.find(id);
+    markDirty(figure->getBounds());
+    removeFigureKey(*figure);
+    spatialIndex.remove(id);
+    figures.erase(id);
+    footprints.erase(id);
+    if (selectedID == id) {
+        selectedID = -1;
+    }
+}
+
+void Board::replaceFigure(int id, const Shape& shape) {
+    Shape* figure = figures.modify(id);
+    markDirty(figure->getBounds());
+    removeFigureKey(*figure);
+    *figure = shape;
+    addFigureKey(*figure);
+    spatialIndex.update(id, figure->getBounds());
+    markDirty(figure->getBounds());
+    footprints.erase(id);
+}
+
+void Board::clearFigures() {
+    figures.clear();
+    footprints.clear();
+    figureKeys.clear();
+    selectedID = -1;
+    spatialIndex.clear();
+    markAllDirty();
+}
+
+// Loading replaces the board wholesale, so there is nothing left to undo and the journal restarts from a checkpoint.
+void Board::resetHistory() {
+    history.clear();
+    historyPosition = 0;
+    if (journal.isOpen() && !journal.checkpoint(journal.getPath(), checkpointRecords())) {
+        error() << "Could not write journal " << journal.getPath() << ". Journaling stopped.\n";
+        journal.close();
+    }
+}
+
+std::vector<JournalRecord> Board::checkpointRecords() const {
+    std::vector<JournalRecord> records;
+    records.reserve(figures.size() + 1);
+    records.push_back(JournalRecord::resize(boardWidth, boardHeight));
+    for (const auto& slot : figures) {
+        records.push_back(JournalRecord::put(slot.id, slot.shape, slot.sequence));
+    }
+    return records;
+}
+
+// Checkpointing once the records since the last one outnumber the figures keeps replay proportional
+// to the board while costing O(1) amortized per change.
+void Board::writeJournal(const std::vector<JournalRecord>& records) {
+    if (!journal.isOpen()) {
+        return;
+    }
+    bool written = journal.append(records);
+    if (written && journal.recordsSinceCheckpoint() > std::max(checkpointInterval, figures.size())) {
+        written = journal.checkpoint(journal.getPath(), checkpointRecords());
+    }
+    if (!written) {
+        error() << "Could not write journal " << journal.getPath() << ". Journaling stopped.\n";
+        journal.close();
+    }
+}
+
+void Board::startJournal(const std::string& filePath) {
+    finishBackgroundSave();
+    if (!journal.checkpoint(filePath, checkpointRecords())) {
+        error() << "Could not write journal " << filePath << ".\n";
+        journal.close();
+        return;
+    }
+    message() << "Journaling changes to " << filePath << ".\n";
+}
+
+void Board::stopJournal() {
+    if (!journal.isOpen()) {
+        error() << "Journaling is not active.\n";
+        return;
+    }
+    journal.close();
+    message() << "Journaling stopped.\n";
+}
+
+// Replays the journal into a fresh store and only touches the board once every record applied cleanly.
+void Board::recover(const std::string& filePath) {
+    finishBackgroundSave();
+    std::vector<JournalRecord> records;
+    bool damagedTail = false;
+    std::string failure;
+    if (!Journal::read(filePath, records, damagedTail, failure)) {
+        error() << failure << '\n';
+        return;
+    }
+
+    FigureStore recovered;
+    int width = boardWidth;
+    int height = boardHeight;
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        const JournalRecord& record = records[i];
+        bool applied = true;
+        switch (record.op) {
+            case JournalRecord::Op::Put:
+                applied = isWellFormed(record.figure) && recovered.insert(record.figure.id, toShape(record.figure), record.sequence);
+                break;
+            case JournalRecord::Op::Update:
+                if (Shape* figure = isWellFormed(record.figure) ? recovered.modify(record.figure.id) : nullptr) {
+                    *figure = toShape(record.figure);
+                }
+                else {
+                    applied = false;
+                }
+                break;
+            case JournalRecord::Op::Remove:
+                applied = recovered.erase(record.figure.id);
+                break;
+            case JournalRecord::Op::Clear:
+                recovered.clear();
+                break;
+            case JournalRecord::Op::Resize:
+                width = record.figure.param1;
+                height = record.figure.param2;
+                applied = width > 0 && height > 0 && width <= maxBoardSize && height <= maxBoardSize;
+                break;
+            default:
+                applied = false;
+                break;
+        }
+        if (!applied) {
+            error() << "Error: Journal record " << i << " does not apply to the records before it.\n";
+            error() << "Failed to recover from " << filePath << ". Board was not modified.\n";
+            return;
         }
-        myFile.close();
-    } else {
-        std::cout << "Could not open file " << filePath << " for writing." << std::endl;
     }
+
+    if (width != boardWidth || height != boardHeight) {
+        boardWidth = width;
+        boardHeight = height;
+        grid.resize(boardWidth, boardHeight);
+        shownFrame.resize(boardWidth, boardHeight);
+        fitViewport();
+    }
+    figures = std::move(recovered);
+    footprints.clear();
+    figureKeys.clear();
+    for (const auto& slot : figures) {
+        addFigureKey(slot.shape);
+        shapeIDCounter = std::max(shapeIDCounter, slot.id + 1);
+    }
+    selectedID = -1;
+    rebuildSpatialIndex();
+    markAllDirty();
+    history.clear();
+    historyPosition = 0;
+    message() << figures.size() << " figures recovered from " << filePath << " (" << records.size() << " records replayed"
+              << (damagedTail ? ", damaged tail ignored" : "") << ").\n";
+    // Continuing the journal starts with a checkpoint, which also drops any damaged tail.
+    startJournal(filePath);
+}
+
+const std::string& Board::getJournalFilePath() const {
+    return journalFilePath;
+}
+
+void Board::showStats() const {
+    out() << "Statistics collection is " << (profiler.isEnabled() ? "on" : "off") << ".\n";
+    profiler.report(out());
+}
+
+void Board::setProfiling(bool enabled) {
+    if (enabled) {
+        profiler.enable();
+        message() << "Statistics collection started.\n";
+    }
+    else {
+        profiler.disable();
+        message() << "Statistics collection stopped.\n";
+    }
+}
+
+void Board::resetStats() {
+    profiler.reset();
+    message() << "Statistics cleared.\n";
+}
+
+void Board::writeTrace(const std::string& filePath) const {
+    if (!profiler.writeTrace(filePath)) {
+        error() << "Could not write trace " << filePath << ".\n";
+        return;
+    }
+    message() << "Trace written to " << filePath << '\n';
+}
+
+const std::string& Board::getTraceFilePath() const {
+    return traceFilePath;
+}
+
+Profiler& Board::getProfiler() {
+    return profiler;
+}
+
+// Points every default file of the board at stem plus the usual extension.
+void Board::setFileStem(const std::string& stem) {
+    filePath = stem + ".txt";
+    binaryFilePath = stem + ".scene";
+    journalFilePath = stem + ".journal";
+    traceFilePath = stem + ".trace.json";
+}
+
+void Board::save(const std::string& filePath) {
+    finishBackgroundSave();
+    report(writeTextScene(filePath, figures));
+}
+
+void Board::saveBinary(const std::string& filePath) {
+    finishBackgroundSave();
+    report(writeBinaryScene(filePath, figures, boardWidth, boardHeight));
+}
+
+// Writes a snapshot of the figures on another thread; the outcome is reported by the first command
+// that runs after the write finishes.
+void Board::saveInBackground(const std::string& filePath, bool binary) {
+    finishBackgroundSave();
+    FigureStore::Snapshot snapshot = figures.snapshot();
+    message() << "Saving " << snapshot.size() << " figures to " << filePath << " in the background.\n";
+
+    saveLine = errorLine;
+    pendingSaveListened = static_cast<bool>(saveListener);
+    pendingSave = std::async(std::launch::async, [snapshot = std::move(snapshot), filePath, binary, width = boardWidth, height = boardHeight,
+                                                  listener = saveListener]() mutable {
+        SaveReport outcome;
+        {
+            // Dropped before the result is published, so once it is collected the store no longer shares its slots.
+            FigureStore::Snapshot figuresToWrite = std::move(snapshot);
+            outcome = binary ? writeBinaryScene(filePath, figuresToWrite, width, height) : writeTextScene(filePath, figuresToWrite);
+        }
+        if (listener) {
+            listener(outcome);
+        }
+        return outcome;
+    });
+}
+
+void Board::pollBackgroundSave() {
+    if (pendingSave.valid() && pendingSave.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        finishBackgroundSave();
+    }
+}
+
+void Board::finishBackgroundSave() {
+    if (!pendingSave.valid()) {
+        return;
+    }
+    SaveReport outcome = pendingSave.get();
+    figures.snapshotsReleased();
+    if (pendingSaveListened) {
+        return;
+    }
+
+    std::size_t currentLine = errorLine;
+    errorLine = saveLine;
+    report(outcome);
+    errorLine = currentLine;
+}
+
+void Board::report(const SaveReport& outcome) const {
+    (outcome.failed ? error() : message()) << outcome.text << '\n';
+}
+
+// Records are validated straight out of the mapping; the board is only rebuilt once every record passed.
+void Board::loadBinary(const std::string& filePath) {
+    finishBackgroundSave();
+    MappedFile file(filePath);
+    if (!file.isOpen()) {
+        error() << "Could not open file " << filePath << " for reading.\n";
+        return;
+    }
+    if (file.readError()) {
+        error() << "Could not read file " << filePath << ": " << file.readError().message() << ".\n";
+        return;
+    }
+    if (file.size() == 0) {
+        error() << "The file " << filePath << " is empty. Nothing to load.\n";
+        return;
+    }
+
+    auto reject = [this](const std::string& reason) {
+        error() << "Error: " << reason << '\n';
+        error() << "Failed to load file. Board was not modified.\n";
+    };
+
+    SceneHeader header{};
+    if (file.size() < sizeof(header)) {
+        reject(filePath + " is not a binary scene file.");
+        return;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (!std::equal(std::begin(header.magic), std::end(header.magic), SceneHeader::expectedMagic)) {
+        reject(filePath + " is not a binary scene file.");
+        return;
+    }
+    if (header.version != SceneHeader::currentVersion || header.recordSize != sizeof(SceneRecord)) {
+        reject("Unsupported scene file version " + std::to_string(header.version) + ".");
+        return;
+    }
+    if ((file.size() - sizeof(header)) / sizeof(SceneRecord) != header.recordCount ||
+        (file.size() - sizeof(header)) % sizeof(SceneRecord) != 0) {
+        reject("Scene file is truncated or has trailing data.");
+        return;
+    }
+    if (header.boardWidth <= 0 || header.boardHeight <= 0 || header.boardWidth > maxBoardSize || header.boardHeight > maxBoardSize) {
+        reject("Invalid board size in scene file.");
+        return;
+    }
+
+    const char* recordData = file.data() + sizeof(header);
+    auto recordAt = [recordData](std::size_t index) {
+        SceneRecord record;
+        std::memcpy(&record, recordData + index * sizeof(SceneRecord), sizeof(record));
+        return record;
+    };
+
+    std::size_t count = static_cast<std::size_t>(header.recordCount);
+    std::unordered_map<FigureKey, int, FigureKeyHash> loadedKeys;
+    std::unordered_set<int> loadedIDs;
+    loadedKeys.reserve(count);
+    loadedIDs.reserve(count);
+    int nextID = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        SceneRecord record = recordAt(i);
+        if (!isWellFormed(record)) {
+            reject("Record " + std::to_string(i) + " is malformed.");
+            return;
+        }
+        if (record.id < 0 || record.id == std::numeric_limits<std::int32_t>::max()) {
+            reject("Record " + std::to_string(i) + " has an invalid figure ID.");
+            return;
+        }
+        if (record.shapeType == static_cast<std::uint8_t>(ShapeType::Circle) && record.param1 <= 0) {
+            reject("Record " + std::to_string(i) + " has an invalid radius for circle.");
+            return;
+        }
+
+        Shape shape = toShape(record);
+        if (shape.isOutOfBounds(header.boardWidth, header.boardHeight)) {
+            reject("Record " + std::to_string(i) + " is out of bounds.");
+            return;
+        }
+        if (!loadedKeys.emplace(shape.getKey(), 1).second) {
+            reject("Record " + std::to_string(i) + " duplicates an earlier figure.");
+            return;
+        }
+        if (!loadedIDs.insert(record.id).second) {
+            reject("Duplicate figure ID " + std::to_string(record.id) + " found.");
+            return;
+        }
+        nextID = std::max(nextID, record.id + 1);
+    }
+
+    if (header.boardWidth != boardWidth || header.boardHeight != boardHeight) {
+        boardWidth = header.boardWidth;
+        boardHeight = header.boardHeight;
+        grid.resize(boardWidth, boardHeight);
+        shownFrame.resize(boardWidth, boardHeight);
+        fitViewport();
+    }
+    figures.clear();
+    footprints.clear();
+    figures.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        SceneRecord record = recordAt(i);
+        figures.insert(record.id, toShape(record));
+    }
+    figureKeys.swap(loadedKeys);
+    shapeIDCounter = std::max(shapeIDCounter, nextID);
+    selectedID = -1;
+    rebuildSpatialIndex();
+    markAllDirty();
+    resetHistory();
+    message() << count << " figures loaded from " << filePath << '\n';
 }
 
 void Board::clear(const std::string& filePath) {
+    finishBackgroundSave();
     if (figures.empty()) {
-        std::cout << "There are no figures. Clear command cannot be performed." << std::endl;
+        error() << "There are no figures. Clear command cannot be performed.\n";
     }
     else {
-        figures.clear();
+        // The snapshot keeps the old slots for undo; the store starts a fresh vector instead of copying them.
+        Change change{Change::Type::Clear, "clear", -1, 0, std::nullopt, std::nullopt, figures.snapshot()};
+        clearFigures();
+        recordChange(std::move(change));
         std::ofstream ofs;
         ofs.open(filePath, std::ofstream::out | std::ofstream::trunc);
         ofs.close();
-        std::cout << "All shapes are removed from the board. File is empty as well." << std::endl;
+        message() << "All shapes are removed from the board. File is empty as well.\n";
     }
 }
 
-std::string Board::getFilePath() const {
+void Board::resize(int width, int height) {
+    if (width <= 0 || height <= 0 || width > maxBoardSize || height > maxBoardSize) {
+        error() << "Invalid board size. Width and height must be between 1 and " << maxBoardSize << ".\n";
+        return;
+    }
+
+    boardWidth = width;
+    boardHeight = height;
+    grid.resize(width, height);
+    shownFrame.resize(width, height);
+    markAllDirty();
+    writeJournal({JournalRecord::resize(width, height)});
+    message() << "Board resized to " << width << "x" << height << ".\n";
+    fitViewport();
+}
+
+const std::string& Board::getFilePath() const {
     return filePath;
 }
 
+const std::string& Board::getBinaryFilePath() const {
+    return binaryFilePath;
+}
+
 //Assignment-3
 void Board::select(int ID)  {
-    if (ID >= 0 && ID < figures.size()) {
+    if (const Shape* selectedFigure = figures.find(ID)) {
         selectedID = ID;
-        std::shared_ptr<Figure> selectedFigure = figures[selectedID].second;
-        std::cout << "Shape [" << selectedID << "] selected: " << selectedFigure->getInfo() << std::endl;
+        message() << "Shape [" << selectedID << "] selected: " << selectedFigure->getInfo() << '\n';
     } else {
-        std::cout << "Shape with ID " << ID << " not found." << std::endl;
+        error() << "Shape with ID " << ID << " not found.\n";
         selectedID = -1;
     }
 }
 
+// Selects a figure without reporting it; an ID that is no longer on the board clears the selection.
+void Board::setSelection(int ID) {
+    selectedID = figures.find(ID) != nullptr ? ID : -1;
+}
+
 void Board::select(int x, int y)  {
-    bool found = false;
-    for (int i = 0; i < figures.size(); ++i) {
-        auto& figure = figures[i].second;
-        if (figure != nullptr && figure->x == x && figure->y == y) {
-            selectedID = i;
-            std::cout << "Shape [" << selectedID << "] at (" << x << ", " << y << ") selected: " << figure->getInfo() << std::endl;
-            found = true;
-            break;
-        }
+    selectedID = figureAt(x, y);
+    if (selectedID == -1) {
+        error() << "No shape found at (" << x << ", " << y << ").\n";
+        return;
     }
+    message() << "Shape [" << selectedID << "] at (" << x << ", " << y << ") selected: " << figures.find(selectedID)->getInfo() << '\n';
+}
 
-    if (!found) {
-        std::cout << "No shape found at (" << x << ", " << y << ")." << std::endl;
-        selectedID = -1;
+// The topmost figure covering the cell, or failing that the topmost one anchored there; -1 if there is none.
+int Board::figureAt(int x, int y) const {
+    std::vector<int> covering = figuresAt(x, y);
+    if (!covering.empty()) {
+        return covering.back();
     }
+
+    std::vector<int> anchored = spatialIndex.query(x, y);
+    sortByDrawOrder(anchored);
+    for (int id : anchored) {
+        const Shape* figure = figures.find(id);
+        if (figure->common().x == x && figure->common().y == y) {
+            return id;
+        }
+    }
+    return -1;
 }
 
 void Board::remove() {
     if (selectedID == -1) {
-        std::cout << "No shape is currently selected. Please select a shape first." << std::endl;
+        error() << "No shape is currently selected. Please select a shape first.\n";
         return;
     }
 
-    figures.erase(figures.begin() + selectedID);
-    std::cout << "Shape [" << selectedID << "] removed." << std::endl;
-
-    for (int i = selectedID; i < figures.size(); ++i) {
-        figures[i].first = i;
-    }
+    const Shape* figure = figures.find(selectedID);
+    Change change{Change::Type::Remove, "remove", selectedID, figures.sequenceOf(selectedID), *figure, std::nullopt, std::nullopt};
+    markDirty(figure->getBounds());
+    removeFigureKey(*figure);
+    spatialIndex.remove(selectedID);
+    figures.erase(selectedID);
+    footprints.erase(selectedID);
+    recordChange(std::move(change));
+    message() << "Shape [" << selectedID << "] removed.\n";
 
     selectedID = -1;
 }
 
-void Board::edit(int x, int y, int parameter1, int parameter2, const std::string& colorStr, const std::string& fillModeStr) {
+void Board::edit(int x, int y, int parameter1, int parameter2, std::string_view colorStr, std::string_view fillModeStr) {
     if (selectedID == -1) {
-        std::cout << "No shape is currently selected. Please select a shape first." << std::endl;
+        error() << "No shape is currently selected. Please select a shape first.\n";
         return;
     }
 
-    std::shared_ptr<Figure>& figure = figures[selectedID].second;
+    Shape* figure = figures.modify(selectedID);
+    Change change{Change::Type::Update, "edit", selectedID, 0, *figure, std::nullopt, std::nullopt};
+    markDirty(figure->getBounds());
+    removeFigureKey(*figure);
+    footprints.erase(selectedID);
 
-    figure->x = x;
-    figure->y = y;
+    figure->common().x = x;
+    figure->common().y = y;
 
-    if (auto rect = dynamic_cast<Rectangle*>(figure.get())) {
-        rect->width = parameter1;
-        rect->height = parameter2;
-    }
-    else if (auto circ = dynamic_cast<Circle*>(figure.get())) {
-        circ->radius = parameter1;
-    }
-    else if (auto tri = dynamic_cast<Triangle*>(figure.get())) {
-        tri->height = parameter1;
-    }
-    else if (auto line = dynamic_cast<Line*>(figure.get())) {
-        line->x2 = parameter1;
-        line->y2 = parameter2;
-    }
-    else {
-        std::cout << "Unknown figure type." << std::endl;
-        return;
+    switch (figure->getType()) {
+        case ShapeType::Rectangle: {
+            auto& rect = std::get<Rectangle>(figure->figure);
+            rect.width = parameter1;
+            rect.height = parameter2;
+            break;
+        }
+        case ShapeType::Circle:
+            std::get<Circle>(figure->figure).radius = parameter1;
+            break;
+        case ShapeType::Triangle:
+            std::get<Triangle>(figure->figure).height = parameter1;
+            break;
+        case ShapeType::Line: {
+            auto& line = std::get<Line>(figure->figure);
+            line.x2 = parameter1;
+            line.y2 = parameter2;
+            break;
+        }
+        default:
+            error() << "Unknown figure type.\n";
+            addFigureKey(*figure);
+            return;
     }
 
     ColorName colorName = Color::fromString(colorStr);
     if (colorName != ColorName::Invalid) {
-        figure->color = Color(colorName);
+        figure->common().color = Color(colorName);
     }
 
-    figure->fillMode = (fillModeStr == "fill") ? FillMode::Fill : FillMode::Frame;
+    figure->common().fillMode = (fillModeStr == "fill") ? FillMode::Fill : FillMode::Frame;
+    addFigureKey(*figure);
+    spatialIndex.update(selectedID, figure->getBounds());
+    markDirty(figure->getBounds());
+    change.after = *figure;
+    recordChange(std::move(change));
 
-    std::cout << "Shape [" << selectedID << "] edited: New properties set." << std::endl;
+    message() << "Shape [" << selectedID << "] edited: New properties set.\n";
 }
 
 
-void Board::paint(const std::string& colorStr) {
+void Board::paint(std::string_view colorStr) {
     if (selectedID == -1) {
-        std::cout << "No shape is currently selected. Please select a shape first." << std::endl;
+        error() << "No shape is currently selected. Please select a shape first.\n";
         return;
     }
 
     ColorName colorName = Color::fromString(colorStr);
     if (colorName == ColorName::Invalid) {
-        std::cout << "Invalid color specified." << std::endl;
+        error() << "Invalid color specified.\n";
         return;
     }
     Color newColor(colorName);
 
-    figures[selectedID].second->color = newColor;
-    std::cout << "Shape [" << selectedID << "] painted " << newColor.getName() << "." << std::endl;
+    Shape* figure = figures.modify(selectedID);
+    Change change{Change::Type::Update, "paint", selectedID, 0, *figure, std::nullopt, std::nullopt};
+    removeFigureKey(*figure);
+    figure->common().color = newColor;
+    addFigureKey(*figure);
+    markDirty(figure->getBounds());
+    change.after = *figure;
+    recordChange(std::move(change));
+    message() << "Shape [" << selectedID << "] painted " << newColor.getName() << ".\n";
 }
 
 void Board::move(int newX, int newY) {
     if (selectedID == -1) {
-        std::cout << "No shape is currently selected. Please select a shape first." << std::endl;
+        error() << "No shape is currently selected. Please select a shape first.\n";
         return;
     }
 
-    auto& figure = figures[selectedID].second;
-    figure->x = newX;
-    figure->y = newY;
-    std::cout << "Shape [" << selectedID << "] moved to (" << newX << ", " << newY << ")." << std::endl;
+    Shape* figure = figures.modify(selectedID);
+    Change change{Change::Type::Update, "move", selectedID, 0, *figure, std::nullopt, std::nullopt};
+    markDirty(figure->getBounds());
+    removeFigureKey(*figure);
+    figure->common().x = newX;
+    figure->common().y = newY;
+    // A line keeps its far endpoint, so moving the anchor changes its shape; other footprints just follow the anchor.
+    if (figure->getType() == ShapeType::Line) {
+        footprints.erase(selectedID);
+    }
+    addFigureKey(*figure);
+    spatialIndex.update(selectedID, figure->getBounds());
+    markDirty(figure->getBounds());
+    change.after = *figure;
+    recordChange(std::move(change));
+    message() << "Shape [" << selectedID << "] moved to (" << newX << ", " << newY << ").\n";
 }
\ No newline at end of file
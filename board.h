@@ -2,39 +2,234 @@
 #include <vector>
 #include <iostream>
 #include "figure.h"
+#include "footprint.h"
+#include "framebuffer.h"
+#include "spatial_index.h"
+#include "figure_store.h"
+#include "journal.h"
+#include "profiler.h"
+#include "thread_pool.h"
+#include <deque>
+#include <functional>
+#include <future>
 #include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
 #include "enums.h"
 
 class Board {
 public:
-    Board() : grid(boardHeight, std::vector<std::string>(boardWidth, " ")), shapeIDCounter(0), selectedID(-1) {}
+    struct SaveReport {
+        bool failed;
+        std::string text;
+    };
+    // Receives a background save's result on the thread that wrote the file, as soon as it is written.
+    using SaveListener = std::function<void(const SaveReport&)>;
+
+    // One undoable command, holding the figure as it was before and after so it can be applied either way.
+    struct Change {
+        enum class Type {
+            Add,
+            Remove,
+            Update,
+            Clear
+        };
+
+        Type type;
+        const char* command;
+        int id;
+        std::int64_t sequence;
+        std::optional<Shape> before;
+        std::optional<Shape> after;
+        std::optional<FigureStore::Snapshot> cleared;
+    };
+
+    // One edit fed to applyBatch. Move and paint name their figure by ID, since producers have no selection;
+    // param2 is ignored for triangles and circles, as in add.
+    struct Operation {
+        enum class Type : std::uint8_t {
+            Add,
+            Move,
+            Paint
+        };
+
+        Type type;
+        ShapeType shapeType;
+        ColorName color;
+        FillMode fillMode;
+        int id;
+        int x;
+        int y;
+        int param1;
+        int param2;
+    };
+
+    struct BatchOutcome {
+        std::size_t applied = 0;
+        std::size_t duplicates = 0;
+        std::size_t outOfBounds = 0;
+        std::size_t missing = 0;
+        std::size_t invalid = 0;
+    };
+
+    explicit Board(int width = 10, int height = 10)
+            : shapeIDCounter(0), selectedID(-1), boardWidth(width), boardHeight(height), grid(width, height), shownFrame(width, height) {}
+    ~Board();
 
     void print() const;
-    [[nodiscard]] std::vector<std::shared_ptr<Figure>> getFigures() const;
-    [[nodiscard]] bool isDuplicate(const std::shared_ptr<Figure>& figure) const;
+    void appendFrame(std::string& out) const;
+    [[nodiscard]] int labelWidth() const;
+    [[nodiscard]] bool isPrintable() const;
+    void reportUnprintable(std::ostream& stream) const;
+    void sampleRow(const Framebuffer& frame, int displayRow, int firstColumn, int lastColumn, std::vector<Framebuffer::Cell>& line) const;
+    void present(const std::vector<Rect>& changed, bool repaint);
+    void printChanges(const std::vector<Rect>& changed);
+    void writeFrame() const;
+    [[nodiscard]] const FigureStore& getFigures() const;
+    [[nodiscard]] bool isDuplicate(const Shape& figure) const;
+    void addFigureKey(const Shape& figure);
+    void removeFigureKey(const Shape& figure);
 
     void draw();
+    bool render(std::vector<Rect>& tiles);
+    void reportUnrenderable(std::ostream& stream) const;
     void list() const;
-    static void shapes();
+    void list(std::ostream& stream) const;
+    void shapes() const;
     void add(ShapeType shapeType, ColorName color, int x, int y, int parameter1, int parameter2, FillMode fillMode);
-    //void undo();
+    void undo();
+    void redo();
     void clear(const std::string& filePath);
-    void save(const std::string& filePath) const;
+    BatchOutcome applyBatch(const std::vector<Operation>& operations);
+    void save(const std::string& filePath);
     void load(const std::string& filePath);
-    [[nodiscard]] std::string getFilePath() const;
+    void saveBinary(const std::string& filePath);
+    void loadBinary(const std::string& filePath);
+    void saveInBackground(const std::string& filePath, bool binary);
+    void pollBackgroundSave();
+    void finishBackgroundSave();
+    [[nodiscard]] const std::string& getFilePath() const;
+    [[nodiscard]] const std::string& getBinaryFilePath() const;
 
     void select(int ID);
     void select(int x, int y);
+    [[nodiscard]] int figureAt(int x, int y) const;
+    [[nodiscard]] int getSelectedID() const { return selectedID; }
+    void setSelection(int ID);
     void remove();
-    void edit(int x, int y, int parameter1, int parameter2, const std::string& colorStr, const std::string& fillModeStr);
-    void paint(const std::string& colorStr);
+    void edit(int x, int y, int parameter1, int parameter2, std::string_view colorStr, std::string_view fillModeStr);
+    void paint(std::string_view colorStr);
     void move(int newX, int newY);
+    void resize(int width, int height);
+    void setDisplayMode(DisplayMode mode);
+    void setViewport(int x, int y, int width, int height, int zoomFactor);
+    void resetViewport();
+    void fitViewport();
+    void startJournal(const std::string& filePath);
+    void stopJournal();
+    void recover(const std::string& filePath);
+    [[nodiscard]] const std::string& getJournalFilePath() const;
+    void showStats() const;
+    void setProfiling(bool enabled);
+    void resetStats();
+    void writeTrace(const std::string& filePath) const;
+    [[nodiscard]] const std::string& getTraceFilePath() const;
+    Profiler& getProfiler();
+    void setFileStem(const std::string& stem);
+
+    void putFigure(int id, const Shape& shape, std::int64_t sequence);
+    void dropFigure(int id);
+    void replaceFigure(int id, const Shape& shape);
+    void clearFigures();
+    void recordChange(Change change);
+    void rememberChange(Change change);
+    void applyChange(const Change& change, bool forward);
+    [[nodiscard]] std::vector<JournalRecord> journalRecords(const Change& change, bool forward) const;
+    [[nodiscard]] std::vector<JournalRecord> checkpointRecords() const;
+    void writeJournal(const std::vector<JournalRecord>& records);
+    void resetHistory();
+
+    [[nodiscard]] std::vector<int> figuresAt(int x, int y) const;
+    void sortByDrawOrder(std::vector<int>& ids) const;
+    void rebuildSpatialIndex();
+
+    static ThreadPool& threadPool();
+
+    // Data the user asked for goes to out(); confirmations to message(), which quiet mode silences; failures to error().
+    std::ostream& out() const;
+    std::ostream& message() const;
+    std::ostream& error() const;
+    void setOutput(std::ostream& stream, std::ostream& errorStream);
+    // Background saves started while a listener is set report to it instead of to the board's output.
+    void setSaveListener(SaveListener listener);
+    void setQuiet(bool suppressMessages);
+    void setErrorLine(std::size_t line);
+    void report(const SaveReport& outcome) const;
+    [[nodiscard]] std::size_t getErrorCount() const { return errorCount; }
+
+    [[nodiscard]] Rect getBoardRect() const;
+    [[nodiscard]] Rect getVisibleRect() const;
+    [[nodiscard]] int displayColumns() const;
+    [[nodiscard]] int displayRows() const;
+    void markDirty(const Rect& region);
+    void markAllDirty();
+    [[nodiscard]] bool isRendered() const { return !fullRedraw && dirtyRegions.empty(); }
+    template<typename Target>
+    void drawFigure(int id, Target& target, const Rect& clip) const;
+    void cullOccluded(std::vector<int>& ids, const Rect& region) const;
+    void cacheFootprints(const std::vector<std::vector<int>>& tileFigures);
+    void collectTiles(const Rect& region, std::vector<Rect>& tiles, std::unordered_map<std::int64_t, std::size_t>& tileJobs) const;
+    void collectFigureTiles(int id, const Rect& region, std::vector<Rect>& tiles, std::unordered_map<std::int64_t, std::size_t>& tileJobs) const;
 
     int shapeIDCounter;
     int selectedID;
-    int boardWidth = 10;
-    int boardHeight = 10;
-    std::vector<std::vector<std::string>> grid;
-    std::vector<std::pair<int, std::shared_ptr<Figure>>> figures;
+    static constexpr int maxBoardSize = 1000000;
+    // Larger frames are refused instead of being built as one string of several bytes per cell.
+    static constexpr long long maxPrintedCells = 4000000;
+    int boardWidth;
+    int boardHeight;
+    Framebuffer grid;
+    static constexpr std::size_t maxDirtyRegions = 16;
+    // Regions spanning at most this many tiles are redrawn tile by tile without looking up what is in them.
+    static constexpr long long smallRegionTiles = 16;
+    // Draws that would leave more tiles than this in the grid are refused, which caps its cells at 256 MB.
+    static constexpr std::size_t maxRenderedTiles = 1 << 16;
+    std::vector<Rect> dirtyRegions;
+    bool fullRedraw = true;
+    FigureStore figures;
+    SpatialIndex spatialIndex;
+    std::unordered_map<FigureKey, int, FigureKeyHash> figureKeys;
+    // Cached rasterizations by figure ID; dropped whenever a figure's shape relative to its anchor changes.
+    std::unordered_map<int, Footprint> footprints;
+    mutable std::string frameBuffer;
+    std::ostream* output = &std::cout;
+    std::ostream* errorOutput = &std::cout;
+    bool quiet = false;
+    std::size_t errorLine = 0;
+    mutable std::size_t errorCount = 0;
+    DisplayMode displayMode = DisplayMode::Full;
+    // Board area that draw keeps up to date and prints, empty for the whole board; each printed cell stands for zoom x zoom board cells.
+    Rect viewport;
+    int zoom = 1;
+    Framebuffer shownFrame;
+    std::future<SaveReport> pendingSave;
+    std::size_t saveLine = 0;
+    SaveListener saveListener;
+    // The pending save reports to the listener that was set when it started, so collecting it prints nothing.
+    bool pendingSaveListened = false;
+    static constexpr std::size_t maxHistory = 10000;
+    std::deque<Change> history;
+    std::size_t historyPosition = 0;
+    // The journal is compacted once it holds more records than this or than there are figures.
+    static constexpr std::size_t checkpointInterval = 4096;
+    Journal journal;
+    Profiler profiler;
+    bool shownValid = false;
+    // Width of the row labels in the frame on screen, which places every cell printChanges rewrites.
+    int shownLabelWidth = 2;
     std::string filePath = R"(C:\KSE\OOP_design\Assignment_3\myFile.txt)";
+    std::string binaryFilePath = R"(C:\KSE\OOP_design\Assignment_3\myFile.scene)";
+    std::string journalFilePath = R"(C:\KSE\OOP_design\Assignment_3\myFile.journal)";
+    std::string traceFilePath = R"(C:\KSE\OOP_design\Assignment_3\myFile.trace.json)";
 };
\ No newline at end of file
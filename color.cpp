@@ -1,5 +1,4 @@
 #include "color.h"
-#include "algorithm"
 
 const std::unordered_map<ColorName, std::string> ansiCodeMap = {
         {ColorName::Red, "\033[31m"},
@@ -28,22 +27,8 @@ std::string Color::getName() const {
     }
 }
 
-ColorName Color::fromString(const std::string& colorStr) {
-    static const std::unordered_map<std::string, ColorName> colors = {
-            {"red", ColorName::Red},
-            {"green", ColorName::Green},
-            {"blue", ColorName::Blue},
-            {"yellow", ColorName::Yellow},
-            {"cyan", ColorName::Cyan},
-            {"magenta", ColorName::Magenta},
-            {"white", ColorName::White},
-            {"reset", ColorName::Reset}
-    };
-    std::string lowerColorStr;
-    std::transform(colorStr.begin(), colorStr.end(), std::back_inserter(lowerColorStr),
-                   [](unsigned char c){ return std::tolower(c); });
-    auto it = colors.find(colorStr);
-    return it != colors.end() ? it->second : ColorName::Invalid;
+ColorName Color::fromString(std::string_view colorStr) {
+    return colorKeywords.find(colorStr);
 }
 
 std::string ColorFormatter::getAnsiCode(const Color& color) {
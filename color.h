@@ -1,16 +1,30 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include "keyword_table.h"
 
 enum class ColorName {
     Red, Green, Blue, Yellow, Cyan, Magenta, White, Reset, Invalid
 };
 
+// Color names are matched case-insensitively.
+inline constexpr KeywordTable<ColorName, 8, true> colorKeywords{{{
+        {"red", ColorName::Red},
+        {"green", ColorName::Green},
+        {"blue", ColorName::Blue},
+        {"yellow", ColorName::Yellow},
+        {"cyan", ColorName::Cyan},
+        {"magenta", ColorName::Magenta},
+        {"white", ColorName::White},
+        {"reset", ColorName::Reset}
+}}, ColorName::Invalid};
+
 class Color {
 public:
     explicit Color(ColorName name = ColorName::Reset);
     [[nodiscard]] std::string getName() const;
-    static ColorName fromString(const std::string& colorStr);
+    static ColorName fromString(std::string_view colorStr);
 
     ColorName name;
 };
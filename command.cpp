@@ -0,0 +1,250 @@
+#include "command.h"
+#include "enums.h"
+#include "tokenizer.h"
+
+bool executeCommand(Board& board, std::string_view line) {
+    board.pollBackgroundSave();
+    Tokenizer tokens(line);
+    std::string_view command = tokens.next();
+
+    CommandType commandType = commandKeywords.find(command);
+    if (commandType == CommandType::Invalid) {
+        board.error() << "Unknown command.\n";
+        return true;
+    }
+
+    Profiler::Scope scope(board.getProfiler(), "command", command);
+    switch (commandType) {
+        case CommandType::Draw: {
+            board.draw();
+            break;
+        }
+        case CommandType::List: {
+            board.list();
+            break;
+        }
+        case CommandType::Shapes: {
+            board.shapes();
+            break;
+        }
+        case CommandType::Add: {
+            std::string_view fillModeStr = tokens.next();
+            std::string_view colorStr = tokens.next();
+            std::string_view shapeNameStr = tokens.next();
+
+            ShapeType shapeType = shapeTypeKeywords.find(shapeNameStr);
+            if (shapeType == ShapeType::Invalid) {
+                board.error() << "Invalid shape type.\n";
+                return true;
+            }
+
+            int x, y, param1, param2 = 0;
+            if (!tokens.nextInt(x) || !tokens.nextInt(y) || !tokens.nextInt(param1)) {
+                board.error() << "Invalid parameters for " << shapeNameStr << ".\n";
+                return true;
+            }
+            if (shapeType == ShapeType::Rectangle || shapeType == ShapeType::Line) {
+                if (!tokens.nextInt(param2)) {
+                    board.error() << "Invalid parameters for " << shapeNameStr << ". Needs an additional parameter.\n";
+                    return true;
+                }
+            }
+
+            FillMode fillMode = (fillModeStr == "fill") ? FillMode::Fill : FillMode::Frame;
+
+            ColorName color = Color::fromString(colorStr);
+            if (color == ColorName::Invalid) {
+                board.error() << "Invalid color.\n";
+                return true;
+            }
+
+            board.add(shapeType, color, x, y, param1, param2, fillMode);
+            break;
+        }
+        case CommandType::Undo: {
+            board.undo();
+            break;
+        }
+        case CommandType::Redo: {
+            board.redo();
+            break;
+        }
+        case CommandType::Clear: {
+            board.clear(board.getFilePath());
+            break;
+        }
+        case CommandType::Save: {
+            std::string_view format = tokens.next();
+            bool binary = format == "binary";
+            if ((binary ? tokens.next() : format) == "async") {
+                board.saveInBackground(binary ? board.getBinaryFilePath() : board.getFilePath(), binary);
+            }
+            else if (binary) {
+                board.saveBinary(board.getBinaryFilePath());
+            }
+            else {
+                board.save(board.getFilePath());
+            }
+            break;
+        }
+        case CommandType::Load: {
+            if (tokens.next() == "binary") {
+                board.loadBinary(board.getBinaryFilePath());
+            }
+            else {
+                board.load(board.getFilePath());
+            }
+            break;
+        }
+        case CommandType::Select: {
+            int firstParam, y;
+            if (!tokens.nextInt(firstParam)) {
+                board.error() << "Invalid select command. Please provide either an ID or coordinates.\n";
+            }
+            else if (tokens.atEnd()) {
+                board.select(firstParam);
+            }
+            else if (tokens.nextInt(y)) {
+                board.select(firstParam, y);
+            }
+            else {
+                board.error() << "Invalid select command. Please provide either an ID or coordinates.\n";
+            }
+            break;
+        }
+        case CommandType::Remove: {
+            board.remove();
+            break;
+        }
+        case CommandType::Edit: {
+            int x, y, param1, param2;
+            if (!tokens.nextInt(x) || !tokens.nextInt(y) || !tokens.nextInt(param1) || !tokens.nextInt(param2)) {
+                board.error() << "Invalid parameters for edit command. Expected format: edit x y param1 param2 color fillMode\n";
+                return true;
+            }
+            std::string_view color = tokens.next();
+            std::string_view fillModeStr = tokens.next();
+            if (fillModeStr.empty()) {
+                board.error() << "Invalid parameters for edit command. Expected format: edit x y param1 param2 color fillMode\n";
+                return true;
+            }
+            board.edit(x, y, param1, param2, color, fillModeStr);
+            break;
+        }
+        case CommandType::Paint: {
+            board.paint(tokens.next());
+            break;
+        }
+        case CommandType::Move: {
+            int x, y;
+            if (!tokens.nextInt(x) || !tokens.nextInt(y)) {
+                board.error() << "Invalid move command. Please provide x and y.\n";
+                return true;
+            }
+            board.move(x, y);
+            break;
+        }
+        case CommandType::Display: {
+            DisplayMode mode = displayModeKeywords.find(tokens.next());
+            if (mode == DisplayMode::Invalid) {
+                board.error() << "Invalid display mode. Use 'full' or 'incremental'.\n";
+                return true;
+            }
+            board.setDisplayMode(mode);
+            break;
+        }
+        case CommandType::Resize: {
+            int width, height;
+            if (tokens.nextInt(width) && tokens.nextInt(height)) {
+                board.resize(width, height);
+            }
+            else {
+                board.error() << "Invalid resize command. Please provide width and height.\n";
+            }
+            break;
+        }
+        case CommandType::Viewport: {
+            if (tokens.atEnd()) {
+                board.resetViewport();
+                break;
+            }
+            int x, y, width, height, zoom = 1;
+            if (!tokens.nextInt(x) || !tokens.nextInt(y) || !tokens.nextInt(width) || !tokens.nextInt(height) ||
+                (!tokens.atEnd() && !tokens.nextInt(zoom))) {
+                board.error() << "Invalid viewport command. Expected format: viewport x y width height [zoom]\n";
+                return true;
+            }
+            board.setViewport(x, y, width, height, zoom);
+            break;
+        }
+        case CommandType::Journal: {
+            if (tokens.next() == "off") {
+                board.stopJournal();
+            }
+            else {
+                board.startJournal(board.getJournalFilePath());
+            }
+            break;
+        }
+        case CommandType::Recover: {
+            board.recover(board.getJournalFilePath());
+            break;
+        }
+        case CommandType::Stats: {
+            std::string_view action = tokens.next();
+            if (action.empty()) {
+                board.showStats();
+            }
+            else if (action == "on" || action == "off") {
+                board.setProfiling(action == "on");
+            }
+            else if (action == "reset") {
+                board.resetStats();
+            }
+            else if (action == "trace") {
+                board.writeTrace(board.getTraceFilePath());
+            }
+            else {
+                board.error() << "Invalid stats command. Use stats, stats on, stats off, stats reset or stats trace.\n";
+            }
+            break;
+        }
+        case CommandType::Exit: {
+            board.message() << "Exiting the program.\n";
+            return false;
+        }
+        case CommandType::Invalid:
+            break;
+    }
+    return true;
+}
+
+int runScript(Board& board, std::istream& input) {
+    std::string line;
+    std::size_t lineNumber = 0;
+    std::size_t failedLines = 0;
+    while (std::getline(input, line)) {
+        ++lineNumber;
+        std::size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+
+        board.setErrorLine(lineNumber);
+        std::size_t errorsBefore = board.getErrorCount();
+        bool keepRunning = executeCommand(board, line);
+        if (board.getErrorCount() != errorsBefore) {
+            ++failedLines;
+        }
+        if (!keepRunning) {
+            break;
+        }
+    }
+    std::size_t errorsBefore = board.getErrorCount();
+    board.finishBackgroundSave();
+    if (board.getErrorCount() != errorsBefore) {
+        ++failedLines;
+    }
+    board.setErrorLine(0);
+    return static_cast<int>(failedLines);
+}
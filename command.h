@@ -0,0 +1,11 @@
+#pragma once
+#include <istream>
+#include <string_view>
+#include "board.h"
+
+// Runs one command line against the board. Returns false once the command asks to exit.
+bool executeCommand(Board& board, std::string_view line);
+
+// Runs every line of a script without prompts, skipping blank lines and '#' comments.
+// Errors are reported with their line number; returns the number of lines that failed.
+int runScript(Board& board, std::istream& input);
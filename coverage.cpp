@@ -0,0 +1,11 @@
+#include "coverage.h"
+
+bool Coverage::covers(const Rect& region) const {
+    std::uint64_t mask = columnMask(region.left, region.right);
+    for (int row = region.top; row <= region.bottom; ++row) {
+        if ((rows[row - area.top] & mask) != mask) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "framebuffer.h"
+#include "rect.h"
+
+// One bit per cell of a tile, set for cells that a later figure paints over. A figure whose visible
+// part of the tile is entirely covered would be overwritten, so the rasterizer can skip it.
+class Coverage {
+public:
+    static_assert(Framebuffer::tileSize <= 64, "a tile row must fit in one mask word");
+
+    explicit Coverage(const Rect& area) : area(area) {}
+
+    void set(int x, int y, Framebuffer::Cell) { rows[y - area.top] |= columnMask(x, x); }
+    void fillSpan(int row, int left, int right, Framebuffer::Cell) { rows[row - area.top] |= columnMask(left, right); }
+    [[nodiscard]] bool covers(const Rect& region) const;
+
+private:
+    [[nodiscard]] std::uint64_t columnMask(int left, int right) const {
+        int count = right - left + 1;
+        std::uint64_t bits = count >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << count) - 1;
+        return bits << (left - area.left);
+    }
+
+    Rect area;
+    std::array<std::uint64_t, Framebuffer::tileSize> rows{};
+};
@@ -1,6 +1,5 @@
 #pragma once
-#include <string>
-#include <unordered_map>
+#include "keyword_table.h"
 
 enum class ShapeType {
     Triangle,
@@ -15,7 +14,8 @@ enum class CommandType {
     Draw,
     List,
     Shapes,
-    //Undo,
+    Undo,
+    Redo,
     Clear,
     Save,
     Load,
@@ -25,8 +25,53 @@ enum class CommandType {
     Edit,
     Paint,
     Move,
+    Resize,
+    Display,
+    Viewport,
+    Journal,
+    Recover,
+    Stats,
     Invalid
 };
 
-extern const std::unordered_map<std::string, ShapeType> shapeTypeMap;
-extern const std::unordered_map<std::string, CommandType> commandMap;
\ No newline at end of file
+enum class DisplayMode {
+    Full,
+    Incremental,
+    Invalid
+};
+
+inline constexpr KeywordTable<ShapeType, 4> shapeTypeKeywords{{{
+        {"triangle", ShapeType::Triangle},
+        {"rectangle", ShapeType::Rectangle},
+        {"circle", ShapeType::Circle},
+        {"line", ShapeType::Line}
+}}, ShapeType::Invalid};
+
+inline constexpr KeywordTable<CommandType, 21> commandKeywords{{{
+        {"add", CommandType::Add},
+        {"draw", CommandType::Draw},
+        {"list", CommandType::List},
+        {"shapes", CommandType::Shapes},
+        {"undo", CommandType::Undo},
+        {"redo", CommandType::Redo},
+        {"clear", CommandType::Clear},
+        {"save", CommandType::Save},
+        {"load", CommandType::Load},
+        {"exit", CommandType::Exit},
+        {"select", CommandType::Select},
+        {"remove", CommandType::Remove},
+        {"edit", CommandType::Edit},
+        {"paint", CommandType::Paint},
+        {"move", CommandType::Move},
+        {"resize", CommandType::Resize},
+        {"display", CommandType::Display},
+        {"viewport", CommandType::Viewport},
+        {"journal", CommandType::Journal},
+        {"recover", CommandType::Recover},
+        {"stats", CommandType::Stats}
+}}, CommandType::Invalid};
+
+inline constexpr KeywordTable<DisplayMode, 2> displayModeKeywords{{{
+        {"full", DisplayMode::Full},
+        {"incremental", DisplayMode::Incremental}
+}}, DisplayMode::Invalid};
@@ -1,36 +1,208 @@
 #include <cmath>
+#include <cstdint>
+#include <vector>
 #include "figure.h"
-#include "board.h"
+#include "coverage.h"
+#include "footprint.h"
+#include "framebuffer.h"
+#include "tile_set.h"
 #include "color.h"
 
-bool Figure::isPositionOutOfBounds(int x, int y, int boardWidth, int boardHeight) {
-    return (x < 0 || x >= boardWidth || y < 0 || y >= boardHeight);
+std::size_t FigureKeyHash::operator()(const FigureKey& key) const {
+    std::uint64_t hash = 1469598103934665603ULL;
+    auto mix = [&hash](std::uint64_t value) {
+        hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    };
+    mix(static_cast<std::uint64_t>(key.shapeType) | static_cast<std::uint64_t>(key.color) << 8 | static_cast<std::uint64_t>(key.fillMode) << 16);
+    mix(static_cast<std::uint32_t>(key.x) | static_cast<std::uint64_t>(static_cast<std::uint32_t>(key.y)) << 32);
+    mix(static_cast<std::uint32_t>(key.param1) | static_cast<std::uint64_t>(static_cast<std::uint32_t>(key.param2)) << 32);
+    return static_cast<std::size_t>(hash);
+}
+
+Shape Shape::create(ShapeType shapeType, int x, int y, int param1, int param2, const Color& color, FillMode fillMode) {
+    switch (shapeType) {
+        case ShapeType::Triangle:
+            return Triangle(x, y, param1, color, fillMode);
+        case ShapeType::Rectangle:
+            return Rectangle(x, y, param1, param2, color, fillMode);
+        case ShapeType::Circle:
+            return Circle(x, y, param1, color, fillMode);
+        default:
+            return Line(x, y, param1, param2, color, fillMode);
+    }
+}
+
+FigureKey Shape::getKey() const {
+    const Figure& base = common();
+    return {getType(), base.x, base.y, getParam1(), getParam2(), base.color.name, base.fillMode};
 }
 
-void Triangle::draw(Board& board) {
-    std::string colorCode = ColorFormatter::getAnsiCode(color);
-    std::string resetCode = ColorFormatter::getAnsiCode(Color(ColorName::Reset));
-    std::string colorChar = std::string(1, color.getName()[0]);
+namespace {
 
-    for (int i = 0; i < height; ++i) {
-        int leftMost = x - i;
-        int rightMost = x + i;
-        int posY = y + i;
+long long integerSqrt(long long value) {
+    if (value <= 0) {
+        return 0;
+    }
+    auto root = static_cast<long long>(std::sqrt(static_cast<double>(value)));
+    while (root * root > value) {
+        --root;
+    }
+    while ((root + 1) * (root + 1) <= value) {
+        ++root;
+    }
+    return root;
+}
 
-        for (int posX = leftMost; posX <= rightMost; ++posX) {
-            if (posY >= 0 && posY < board.boardHeight && posX >= 0 && posX < board.boardWidth) {
-                std::string content = colorCode + colorChar + resetCode;
-                if (fillMode == FillMode::Frame && (posX == leftMost || posX == rightMost || i == height - 1)) {
-                    board.grid[posY][posX] = content;
+// The Bresenham walk used for lines advances the major axis every step; after k steps the
+// minor axis has advanced floor((2 * k * minor + major - 1) / (2 * major)).
+long long minorStep(long long step, long long major, long long minor) {
+    if (major == 0) {
+        return 0;
+    }
+    unsigned long long product = static_cast<unsigned long long>(step) * static_cast<unsigned long long>(minor);
+    auto quotient = static_cast<long long>(product / static_cast<unsigned long long>(major));
+    auto remainder = static_cast<long long>(product % static_cast<unsigned long long>(major));
+    return quotient + (2 * remainder + major - 1) / (2 * major);
+}
+
+long long firstMajorStep(long long minorOffset, long long major, long long minor) {
+    if (minorOffset <= 0) {
+        return 0;
+    }
+    if (minorOffset > minor) {
+        return major + 1;
+    }
+    auto step = static_cast<long long>((2.0L * minorOffset - 1) * major / (2.0L * minor));
+    step = std::max(0LL, std::min(step, major));
+    while (step > 0 && minorStep(step - 1, major, minor) >= minorOffset) {
+        --step;
+    }
+    while (minorStep(step, major, minor) < minorOffset) {
+        ++step;
+    }
+    return step;
+}
+
+void visibleSteps(int start, int direction, long long length, int low, int high, long long& first, long long& last) {
+    if (direction > 0) {
+        first = static_cast<long long>(low) - start;
+        last = static_cast<long long>(high) - start;
+    }
+    else {
+        first = static_cast<long long>(start) - high;
+        last = static_cast<long long>(start) - low;
+    }
+    first = std::max(first, 0LL);
+    last = std::min(last, length);
+}
+
+template<typename Target>
+void fillClippedSpan(Target& grid, const Rect& clip, int row, int left, int right, Framebuffer::Cell cell) {
+    left = std::max(left, clip.left);
+    right = std::min(right, clip.right);
+    if (row >= clip.top && row <= clip.bottom && left <= right) {
+        grid.fillSpan(row, left, right, cell);
+    }
+}
+
+template<typename Target>
+void drawCircleOutline(Target& grid, const Rect& clip, int cx, int cy, int radius, Framebuffer::Cell cell) {
+    long long radiusSquared = static_cast<long long>(radius) * radius;
+    long long innerSquared = radiusSquared - radius;
+    long long lastOffset = integerSqrt(radiusSquared / 2);
+
+    // The outline is the ring innerSquared <= a^2 + b^2 <= radiusSquared. Walk one octant (b >= a)
+    // and mirror it, visiting only offsets whose mirrored rows or columns fall inside the clip.
+    std::vector<std::pair<long long, long long>> ranges = {
+            {static_cast<long long>(clip.top) - cy, static_cast<long long>(clip.bottom) - cy},
+            {static_cast<long long>(cy) - clip.bottom, static_cast<long long>(cy) - clip.top},
+            {static_cast<long long>(clip.left) - cx, static_cast<long long>(clip.right) - cx},
+            {static_cast<long long>(cx) - clip.right, static_cast<long long>(cx) - clip.left}
+    };
+    std::sort(ranges.begin(), ranges.end());
+
+    long long next = 0;
+    for (const auto& range : ranges) {
+        long long first = std::max(range.first, next);
+        long long last = std::min(range.second, lastOffset);
+        if (first > last) {
+            continue;
+        }
+        next = last + 1;
+
+        long long outer = integerSqrt(radiusSquared - first * first);
+        long long inner = innerSquared - first * first > 0 ? integerSqrt(innerSquared - first * first - 1) + 1 : 0;
+        for (long long a = first; a <= last; ++a) {
+            while (outer * outer > radiusSquared - a * a) {
+                --outer;
+            }
+            while (inner > 0 && (inner - 1) * (inner - 1) >= innerSquared - a * a) {
+                --inner;
+            }
+
+            long long low = std::max(inner, a);
+            if (low > outer) {
+                continue;
+            }
+            auto offset = static_cast<int>(a);
+            auto nearEdge = static_cast<int>(low);
+            auto farEdge = static_cast<int>(outer);
+
+            for (int row : {cy + offset, cy - offset}) {
+                fillClippedSpan(grid, clip, row, cx + nearEdge, cx + farEdge, cell);
+                fillClippedSpan(grid, clip, row, cx - farEdge, cx - nearEdge, cell);
+            }
+            for (int column : {cx + offset, cx - offset}) {
+                if (column < clip.left || column > clip.right) {
+                    continue;
                 }
-                else if (fillMode == FillMode::Fill) {
-                    board.grid[posY][posX] = content;
+                for (int row = std::max(cy + nearEdge, clip.top); row <= std::min(cy + farEdge, clip.bottom); ++row) {
+                    grid.set(column, row, cell);
+                }
+                for (int row = std::max(cy - farEdge, clip.top); row <= std::min(cy - nearEdge, clip.bottom); ++row) {
+                    grid.set(column, row, cell);
                 }
             }
         }
     }
 }
 
+}
+
+bool Figure::isPositionOutOfBounds(int x, int y, int boardWidth, int boardHeight) {
+    return (x < 0 || x >= boardWidth || y < 0 || y >= boardHeight);
+}
+
+template<typename Target>
+void Triangle::draw(Target& target, const Rect& clip) const {
+    Framebuffer::Cell cell = Framebuffer::encode(color);
+
+    int firstRow = std::max(0, clip.top - y);
+    int lastRow = std::min(height - 1, clip.bottom - y);
+    for (int i = firstRow; i <= lastRow; ++i) {
+        if (fillMode == FillMode::Fill || i == height - 1) {
+            fillClippedSpan(target, clip, y + i, x - i, x + i, cell);
+        }
+        else {
+            fillClippedSpan(target, clip, y + i, x - i, x - i, cell);
+            fillClippedSpan(target, clip, y + i, x + i, x + i, cell);
+        }
+    }
+}
+
+Rect Triangle::getBounds() const {
+    return {x - height + 1, y, x + height - 1, y + height - 1};
+}
+
+bool Triangle::covers(int px, int py) const {
+    int i = py - y;
+    int offset = std::abs(px - x);
+    if (i < 0 || i >= height || offset > i) {
+        return false;
+    }
+    return fillMode == FillMode::Fill || offset == i || i == height - 1;
+}
+
 bool Triangle::isOutOfBounds(int boardWidth, int boardHeight) const {
     return height <= 0 || (y + height - 1 < 0) || (y >= boardHeight) || (x - height + 1 >= boardWidth) || (x + height - 1 < 0);
 }
@@ -43,27 +215,32 @@ std::string Triangle::getSaveFormat() const {
     return "Triangle " + std::to_string(x) + " " + std::to_string(y) + " " + std::to_string(height) + " 0";
 }
 
-void Rectangle::draw(Board& board) {
-    std::string colorCode = ColorFormatter::getAnsiCode(color);
-    std::string resetCode = ColorFormatter::getAnsiCode(Color(ColorName::Reset));
-
-    char colorChar = color.getName()[0];
-    std::string filledCell = colorCode + colorChar + resetCode;
+template<typename Target>
+void Rectangle::draw(Target& target, const Rect& clip) const {
+    Framebuffer::Cell filledCell = Framebuffer::encode(color);
 
-    for (int row = y; row < y + height; ++row) {
-        for (int col = x; col < x + width; ++col) {
-            if (row >= 0 && row < board.boardHeight && col >= 0 && col < board.boardWidth) {
-                if (fillMode == FillMode::Frame && (row == y || row == y + height - 1 || col == x || col == x + width - 1)) {
-                    board.grid[row][col] = filledCell;
-                }
-                else if (fillMode == FillMode::Fill) {
-                    board.grid[row][col] = filledCell;
-                }
-            }
+    for (int row = std::max(y, clip.top); row <= std::min(y + height - 1, clip.bottom); ++row) {
+        if (fillMode == FillMode::Fill || row == y || row == y + height - 1) {
+            fillClippedSpan(target, clip, row, x, x + width - 1, filledCell);
+        }
+        else {
+            fillClippedSpan(target, clip, row, x, x, filledCell);
+            fillClippedSpan(target, clip, row, x + width - 1, x + width - 1, filledCell);
         }
     }
 }
 
+Rect Rectangle::getBounds() const {
+    return {x, y, x + width - 1, y + height - 1};
+}
+
+bool Rectangle::covers(int px, int py) const {
+    if (!getBounds().contains(px, py)) {
+        return false;
+    }
+    return fillMode == FillMode::Fill || py == y || py == y + height - 1 || px == x || px == x + width - 1;
+}
+
 bool Rectangle::isOutOfBounds(int boardWidth, int boardHeight) const {
     return width <= 0 || height <= 0 || (x + width - 1 < 0) || (y + height - 1 < 0) || x >= boardWidth || y >= boardHeight;
 }
@@ -76,25 +253,34 @@ std::string Rectangle::getSaveFormat() const {
     return "Rectangle " + std::to_string(x) + " " + std::to_string(y) + " " + std::to_string(width) + " " + std::to_string(height);
 }
 
-void Circle::draw(Board& board) {
-    std::string colorCode = ColorFormatter::getAnsiCode(color);
-    std::string resetCode = ColorFormatter::getAnsiCode(Color(ColorName::Reset));
-    char colorChar = color.getName()[0];
-    std::string filledCell = colorCode + colorChar + resetCode;
-
-    for (int i = -radius; i <= radius; ++i) {
-        for (int j = -radius; j <= radius; ++j) {
-            int distanceSquared = i * i + j * j;
-            if ((fillMode == FillMode::Frame && distanceSquared >= radius * radius - radius && distanceSquared <= radius * radius) ||
-                (fillMode == FillMode::Fill && distanceSquared <= radius * radius)) {
-                int drawX = x + j;
-                int drawY = y + i;
-                if (drawX >= 0 && drawX < board.boardWidth && drawY >= 0 && drawY < board.boardHeight) {
-                    board.grid[drawY][drawX] = filledCell;
-                }
-            }
-        }
+template<typename Target>
+void Circle::draw(Target& target, const Rect& clip) const {
+    Framebuffer::Cell filledCell = Framebuffer::encode(color);
+    if (fillMode == FillMode::Frame) {
+        drawCircleOutline(target, clip, x, y, radius, filledCell);
+        return;
     }
+
+    long long radiusSquared = static_cast<long long>(radius) * radius;
+    for (int i = std::max(-radius, clip.top - y); i <= std::min(radius, clip.bottom - y); ++i) {
+        int halfWidth = static_cast<int>(integerSqrt(radiusSquared - static_cast<long long>(i) * i));
+        fillClippedSpan(target, clip, y + i, x - halfWidth, x + halfWidth, filledCell);
+    }
+}
+
+Rect Circle::getBounds() const {
+    return {x - radius, y - radius, x + radius, y + radius};
+}
+
+bool Circle::covers(int px, int py) const {
+    long long i = py - y;
+    long long j = px - x;
+    long long distanceSquared = i * i + j * j;
+    long long radiusSquared = static_cast<long long>(radius) * radius;
+    if (fillMode == FillMode::Frame) {
+        return distanceSquared >= radiusSquared - radius && distanceSquared <= radiusSquared;
+    }
+    return distanceSquared <= radiusSquared;
 }
 
 bool Circle::isOutOfBounds(int boardWidth, int boardHeight) const {
@@ -109,46 +295,58 @@ std::string Circle::getSaveFormat() const {
     return "Circle " + std::to_string(x) + " " + std::to_string(y) + " " + std::to_string(radius) + " 0";
 }
 
-void Line::draw(Board& board) {
-    std::string colorCode = ColorFormatter::getAnsiCode(color);
-    std::string resetCode = ColorFormatter::getAnsiCode(Color(ColorName::Reset));
-    char colorChar = color.getName()[0];
-    std::string lineCell = colorCode + colorChar + resetCode;
-
-    int x1 = x;
-    int y1 = y;
-    int x2 = this->x2;
-    int y2 = this->y2;
-
-    int dx = std::abs(x2 - x1);
-    int dy = std::abs(y2 - y1);
+template<typename Target>
+void Line::draw(Target& target, const Rect& clip) const {
+    Framebuffer::Cell lineCell = Framebuffer::encode(color);
 
-    int sx = (x1 < x2) ? 1 : -1;
-    int sy = (y1 < y2) ? 1 : -1;
+    long long dx = std::abs(static_cast<long long>(x2) - x);
+    long long dy = std::abs(static_cast<long long>(y2) - y);
+    int sx = (x < x2) ? 1 : -1;
+    int sy = (y < y2) ? 1 : -1;
 
-    int err = dx - dy;
+    long long firstColumn, lastColumn, firstRow, lastRow;
+    visibleSteps(x, sx, dx, clip.left, clip.right, firstColumn, lastColumn);
+    visibleSteps(y, sy, dy, clip.top, clip.bottom, firstRow, lastRow);
+    if (firstColumn > lastColumn || firstRow > lastRow) {
+        return;
+    }
 
-    while (true) {
-        if (x1 >= 0 && x1 < board.boardWidth && y1 >= 0 && y1 < board.boardHeight) {
-            board.grid[y1][x1] = lineCell;
+    if (dx >= dy) {
+        firstRow = std::max(firstRow, minorStep(firstColumn, dx, dy));
+        lastRow = std::min(lastRow, minorStep(lastColumn, dx, dy));
+        for (long long row = firstRow; row <= lastRow; ++row) {
+            long long first = std::max(firstColumn, firstMajorStep(row, dx, dy));
+            long long last = std::min(lastColumn, firstMajorStep(row + 1, dx, dy) - 1);
+            if (first <= last) {
+                auto from = static_cast<int>(x + sx * first);
+                auto to = static_cast<int>(x + sx * last);
+                fillClippedSpan(target, clip, static_cast<int>(y + sy * row), std::min(from, to), std::max(from, to), lineCell);
+            }
         }
-
-        if (x1 == x2 && y1 == y2) {
-            break;
+    }
+    else {
+        firstRow = std::max(firstRow, firstMajorStep(firstColumn, dy, dx));
+        lastRow = std::min(lastRow, firstMajorStep(lastColumn + 1, dy, dx) - 1);
+        for (long long row = firstRow; row <= lastRow; ++row) {
+            target.set(static_cast<int>(x + sx * minorStep(row, dy, dx)), static_cast<int>(y + sy * row), lineCell);
         }
+    }
+}
 
-        int e2 = 2 * err;
-
-        if (e2 > -dy) {
-            err -= dy;
-            x1 += sx;
-        }
+Rect Line::getBounds() const {
+    return {std::min(x, x2), std::min(y, y2), std::max(x, x2), std::max(y, y2)};
+}
 
-        if (e2 < dx) {
-            err += dx;
-            y1 += sy;
-        }
+bool Line::covers(int px, int py) const {
+    if (!getBounds().contains(px, py)) {
+        return false;
     }
+
+    long long dx = std::abs(static_cast<long long>(x2) - x);
+    long long dy = std::abs(static_cast<long long>(y2) - y);
+    long long stepX = std::abs(static_cast<long long>(px) - x);
+    long long stepY = std::abs(static_cast<long long>(py) - y);
+    return dx >= dy ? minorStep(stepX, dx, dy) == stepY : minorStep(stepY, dy, dx) == stepX;
 }
 
 bool Line::isOutOfBounds(int boardWidth, int boardHeight) const {
@@ -161,4 +359,21 @@ std::string Line::getInfo() const {
 
 std::string Line::getSaveFormat() const {
     return "Line " + std::to_string(x) + " " + std::to_string(y) + " " + std::to_string(x2) + " " + std::to_string(y2);
-}
\ No newline at end of file
+}
+
+template void Triangle::draw(Framebuffer::Tile&, const Rect&) const;
+template void Triangle::draw(Footprint&, const Rect&) const;
+template void Triangle::draw(Coverage&, const Rect&) const;
+template void Triangle::draw(TileSet&, const Rect&) const;
+template void Rectangle::draw(Framebuffer::Tile&, const Rect&) const;
+template void Rectangle::draw(Footprint&, const Rect&) const;
+template void Rectangle::draw(Coverage&, const Rect&) const;
+template void Rectangle::draw(TileSet&, const Rect&) const;
+template void Circle::draw(Framebuffer::Tile&, const Rect&) const;
+template void Circle::draw(Footprint&, const Rect&) const;
+template void Circle::draw(Coverage&, const Rect&) const;
+template void Circle::draw(TileSet&, const Rect&) const;
+template void Line::draw(Framebuffer::Tile&, const Rect&) const;
+template void Line::draw(Footprint&, const Rect&) const;
+template void Line::draw(Coverage&, const Rect&) const;
+template void Line::draw(TileSet&, const Rect&) const;
@@ -1,30 +1,44 @@
 #pragma once
 #include <string>
-#include <memory>
+#include <variant>
 #include "color.h"
-
-class Board;
+#include "rect.h"
+#include "framebuffer.h"
+#include "enums.h"
 
 enum class FillMode {
     Frame,
     Fill
 };
 
+struct FigureKey {
+    ShapeType shapeType;
+    int x;
+    int y;
+    int param1;
+    int param2;
+    ColorName color;
+    FillMode fillMode;
+
+    bool operator==(const FigureKey& other) const {
+        return shapeType == other.shapeType && x == other.x && y == other.y && param1 == other.param1 &&
+               param2 == other.param2 && color == other.color && fillMode == other.fillMode;
+    }
+};
+
+struct FigureKeyHash {
+    std::size_t operator()(const FigureKey& key) const;
+};
+
 class Figure {
 public:
     Figure(int x, int y, const Color& color = Color(ColorName::Reset), FillMode fillMode = FillMode::Frame)
             : x(x), y(y), color(color), fillMode(fillMode) {}
-    virtual void draw(Board& board) = 0;
-    [[nodiscard]] virtual std::string getInfo() const = 0;
-    [[nodiscard]] virtual std::string getSaveFormat() const = 0;
-    [[nodiscard]] virtual bool isOutOfBounds(int boardWidth, int boardHeight) const = 0;
     static bool isPositionOutOfBounds(int x, int y, int boardWidth, int boardHeight);
 
     void setColor(ColorName newColor) { color = Color(newColor); }
 
-    [[nodiscard]] virtual std::string getShapeType() const = 0;
-    [[nodiscard]] virtual int getParam1() const = 0;
-    [[nodiscard]] virtual int getParam2() const { return 0; }
+    [[nodiscard]] int getParam2() const { return 0; }
 
     int x;
     int y;
@@ -37,13 +51,16 @@ public:
     Triangle(int x, int y, int height, const Color& color = Color(ColorName::Reset), FillMode fillMode = FillMode::Frame)
             : Figure(x, y, color, fillMode), height(height) {}
 
-    void draw(Board& board) override;
-    [[nodiscard]] std::string getInfo() const override;
-    [[nodiscard]] std::string getSaveFormat() const override;
-    [[nodiscard]] bool isOutOfBounds(int boardWidth, int boardHeight) const override;
+    template<typename Target>
+    void draw(Target& target, const Rect& clip) const;
+    [[nodiscard]] Rect getBounds() const;
+    [[nodiscard]] bool covers(int px, int py) const;
+    [[nodiscard]] std::string getInfo() const;
+    [[nodiscard]] std::string getSaveFormat() const;
+    [[nodiscard]] bool isOutOfBounds(int boardWidth, int boardHeight) const;
 
-    [[nodiscard]] std::string getShapeType() const override { return "triangle"; }
-    [[nodiscard]] int getParam1() const override { return height; }
+    [[nodiscard]] std::string getShapeType() const { return "triangle"; }
+    [[nodiscard]] int getParam1() const { return height; }
 
     int height;
 };
@@ -53,14 +70,17 @@ public:
     Rectangle(int x, int y, int width, int height, const Color& color = Color(ColorName::Reset), FillMode fillMode = FillMode::Frame)
             : Figure(x, y, color, fillMode), width(width), height(height) {}
 
-    void draw(Board& board) override;
-    [[nodiscard]] std::string getInfo() const override;
-    [[nodiscard]] std::string getSaveFormat() const override;
-    [[nodiscard]] bool isOutOfBounds(int boardWidth, int boardHeight) const override;
+    template<typename Target>
+    void draw(Target& target, const Rect& clip) const;
+    [[nodiscard]] Rect getBounds() const;
+    [[nodiscard]] bool covers(int px, int py) const;
+    [[nodiscard]] std::string getInfo() const;
+    [[nodiscard]] std::string getSaveFormat() const;
+    [[nodiscard]] bool isOutOfBounds(int boardWidth, int boardHeight) const;
 
-    [[nodiscard]] std::string getShapeType() const override { return "rectangle"; }
-    [[nodiscard]] int getParam1() const override { return width; }
-    [[nodiscard]] int getParam2() const override { return height; }
+    [[nodiscard]] std::string getShapeType() const { return "rectangle"; }
+    [[nodiscard]] int getParam1() const { return width; }
+    [[nodiscard]] int getParam2() const { return height; }
 
     int width, height;
 };
@@ -70,13 +90,16 @@ public:
     Circle(int x, int y, int radius, const Color& color = Color(ColorName::Reset), FillMode fillMode = FillMode::Frame)
             : Figure(x, y, color, fillMode), radius(radius) {}
 
-    void draw(Board& board) override;
-    [[nodiscard]] std::string getInfo() const override;
-    [[nodiscard]] std::string getSaveFormat() const override;
-    [[nodiscard]] bool isOutOfBounds(int boardWidth, int boardHeight) const override;
+    template<typename Target>
+    void draw(Target& target, const Rect& clip) const;
+    [[nodiscard]] Rect getBounds() const;
+    [[nodiscard]] bool covers(int px, int py) const;
+    [[nodiscard]] std::string getInfo() const;
+    [[nodiscard]] std::string getSaveFormat() const;
+    [[nodiscard]] bool isOutOfBounds(int boardWidth, int boardHeight) const;
 
-    [[nodiscard]] std::string getShapeType() const override { return "circle"; }
-    [[nodiscard]] int getParam1() const override { return radius; }
+    [[nodiscard]] std::string getShapeType() const { return "circle"; }
+    [[nodiscard]] int getParam1() const { return radius; }
 
     int radius;
 };
@@ -86,14 +109,49 @@ public:
     Line(int x1, int y1, int x2, int y2, const Color& color = Color(ColorName::Reset), FillMode fillMode = FillMode::Frame)
             : Figure(x1, y1, color, fillMode), x2(x2), y2(y2) {}
 
-    void draw(Board& board) override;
-    [[nodiscard]] std::string getInfo() const override;
-    [[nodiscard]] std::string getSaveFormat() const override;
-    [[nodiscard]] bool isOutOfBounds(int boardWidth, int boardHeight) const override;
+    template<typename Target>
+    void draw(Target& target, const Rect& clip) const;
+    [[nodiscard]] Rect getBounds() const;
+    [[nodiscard]] bool covers(int px, int py) const;
+    [[nodiscard]] std::string getInfo() const;
+    [[nodiscard]] std::string getSaveFormat() const;
+    [[nodiscard]] bool isOutOfBounds(int boardWidth, int boardHeight) const;
 
-    [[nodiscard]] std::string getShapeType() const override { return "line"; }
-    [[nodiscard]] int getParam1() const override { return x2; }
-    [[nodiscard]] int getParam2() const override { return y2; }
+    [[nodiscard]] std::string getShapeType() const { return "line"; }
+    [[nodiscard]] int getParam1() const { return x2; }
+    [[nodiscard]] int getParam2() const { return y2; }
 
     int x2, y2;
-};
\ No newline at end of file
+};
+
+// Alternatives are listed in ShapeType order, so the variant index is the type tag.
+class Shape {
+public:
+    using Variant = std::variant<Triangle, Rectangle, Circle, Line>;
+
+    template<typename T>
+    Shape(T figure) : figure(std::move(figure)) {}
+
+    static Shape create(ShapeType shapeType, int x, int y, int param1, int param2, const Color& color, FillMode fillMode);
+
+    [[nodiscard]] ShapeType getType() const { return static_cast<ShapeType>(figure.index()); }
+    [[nodiscard]] Figure& common() { return std::visit([](Figure& base) -> Figure& { return base; }, figure); }
+    [[nodiscard]] const Figure& common() const { return std::visit([](const Figure& base) -> const Figure& { return base; }, figure); }
+
+    // Target is a board tile, a Footprint being recorded, a tile's Coverage or the TileSet a figure draws on;
+    // figure.cpp instantiates each.
+    template<typename Target>
+    void draw(Target& target, const Rect& clip) const { std::visit([&](const auto& shape) { shape.draw(target, clip); }, figure); }
+    [[nodiscard]] Rect getBounds() const { return std::visit([](const auto& shape) { return shape.getBounds(); }, figure); }
+    [[nodiscard]] bool covers(int px, int py) const { return std::visit([=](const auto& shape) { return shape.covers(px, py); }, figure); }
+    [[nodiscard]] std::string getInfo() const { return std::visit([](const auto& shape) { return shape.getInfo(); }, figure); }
+    [[nodiscard]] bool isOutOfBounds(int boardWidth, int boardHeight) const {
+        return std::visit([=](const auto& shape) { return shape.isOutOfBounds(boardWidth, boardHeight); }, figure);
+    }
+    [[nodiscard]] std::string getShapeType() const { return std::visit([](const auto& shape) { return shape.getShapeType(); }, figure); }
+    [[nodiscard]] int getParam1() const { return std::visit([](const auto& shape) { return shape.getParam1(); }, figure); }
+    [[nodiscard]] int getParam2() const { return std::visit([](const auto& shape) { return shape.getParam2(); }, figure); }
+    [[nodiscard]] FigureKey getKey() const;
+
+    Variant figure;
+};
@@ -0,0 +1,120 @@
+#include "figure_store.h"
+#include <algorithm>
+
+bool FigureStore::insert(int id, const Shape& shape) {
+    return insert(id, shape, nextSequence);
+}
+
+bool FigureStore::insert(int id, const Shape& shape, std::int64_t sequence) {
+    if (positions.count(id) != 0) {
+        return false;
+    }
+    detach();
+    std::vector<Slot>& all = *slots;
+
+    auto grave = tombstones.find(id);
+    if (grave != tombstones.end()) {
+        std::size_t index = grave->second;
+        tombstones.erase(grave);
+        if (all[index].sequence == sequence) {
+            all[index].removed = false;
+            all[index].shape = shape;
+            positions.emplace(id, index);
+            --removedCount;
+            return true;
+        }
+    }
+
+    auto place = std::lower_bound(all.begin(), all.end(), sequence, [](const Slot& slot, std::int64_t value) { return slot.sequence < value; });
+    auto index = static_cast<std::size_t>(place - all.begin());
+    all.insert(place, {id, false, sequence, shape});
+    for (std::size_t i = index + 1; i < all.size(); ++i) {
+        if (!all[i].removed) {
+            positions[all[i].id] = i;
+        }
+        else if (auto moved = tombstones.find(all[i].id); moved != tombstones.end() && moved->second == i - 1) {
+            moved->second = i;
+        }
+    }
+    positions.emplace(id, index);
+    nextSequence = std::max(nextSequence, sequence + 1);
+    return true;
+}
+
+bool FigureStore::erase(int id) {
+    auto it = positions.find(id);
+    if (it == positions.end()) {
+        return false;
+    }
+
+    detach();
+    (*slots)[it->second].removed = true;
+    tombstones[id] = it->second;
+    positions.erase(it);
+    ++removedCount;
+
+    if (removedCount > 32 && removedCount > positions.size()) {
+        compact();
+    }
+    return true;
+}
+
+void FigureStore::reserve(std::size_t count) {
+    detach();
+    slots->reserve(count);
+    positions.reserve(count);
+}
+
+void FigureStore::clear() {
+    if (shared) {
+        slots = std::make_shared<std::vector<Slot>>();
+        shared = false;
+    }
+    slots->clear();
+    positions.clear();
+    tombstones.clear();
+    removedCount = 0;
+}
+
+const Shape* FigureStore::find(int id) const {
+    auto it = positions.find(id);
+    return it != positions.end() ? &(*slots)[it->second].shape : nullptr;
+}
+
+Shape* FigureStore::modify(int id) {
+    auto it = positions.find(id);
+    if (it == positions.end()) {
+        return nullptr;
+    }
+    detach();
+    return &(*slots)[it->second].shape;
+}
+
+FigureStore::Snapshot FigureStore::snapshot() {
+    shared = true;
+    return {slots, positions.size()};
+}
+
+void FigureStore::detach() {
+    if (shared) {
+        slots = std::make_shared<std::vector<Slot>>(*slots);
+        shared = false;
+    }
+}
+
+void FigureStore::compact() {
+    std::vector<Slot>& live = *slots;
+    std::size_t next = 0;
+    for (std::size_t i = 0; i < live.size(); ++i) {
+        if (!live[i].removed) {
+            positions[live[i].id] = next;
+            if (i != next) {
+                live[next] = std::move(live[i]);
+            }
+            ++next;
+        }
+    }
+    live.erase(live.begin() + static_cast<std::ptrdiff_t>(next), live.end());
+    tombstones.clear();
+    removedCount = 0;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "figure.h"
+
+// Figures in draw order. Slots are kept sorted by sequence number, so a figure can be put back at its
+// old place in the order; a removed figure leaves a tombstone that is reused when it comes back.
+class FigureStore {
+public:
+    struct Slot {
+        int id;
+        bool removed;
+        std::int64_t sequence;
+        Shape shape;
+    };
+
+    class const_iterator {
+    public:
+        const_iterator(const Slot* current, const Slot* end) : current(current), end(end) { skipRemoved(); }
+
+        const Slot& operator*() const { return *current; }
+        const Slot* operator->() const { return current; }
+        const_iterator& operator++() { ++current; skipRemoved(); return *this; }
+        bool operator!=(const const_iterator& other) const { return current != other.current; }
+        bool operator==(const const_iterator& other) const { return current == other.current; }
+
+    private:
+        void skipRemoved() { while (current != end && current->removed) ++current; }
+
+        const Slot* current;
+        const Slot* end;
+    };
+
+    // Read-only view of the figures at one point in time. It shares the store's slots until the store next
+    // changes, which copies them first, so taking one is cheap and it stays valid on any thread.
+    class Snapshot {
+    public:
+        Snapshot(std::shared_ptr<const std::vector<Slot>> slots, std::size_t count) : slots(std::move(slots)), count(count) {}
+
+        [[nodiscard]] const_iterator begin() const { return {slots->data(), slots->data() + slots->size()}; }
+        [[nodiscard]] const_iterator end() const { return {slots->data() + slots->size(), slots->data() + slots->size()}; }
+        [[nodiscard]] std::size_t size() const { return count; }
+        [[nodiscard]] bool empty() const { return count == 0; }
+
+    private:
+        std::shared_ptr<const std::vector<Slot>> slots;
+        std::size_t count;
+    };
+
+    bool insert(int id, const Shape& shape);
+    bool insert(int id, const Shape& shape, std::int64_t sequence);
+    bool erase(int id);
+    void clear();
+    void reserve(std::size_t count);
+
+    [[nodiscard]] const Shape* find(int id) const;
+    [[nodiscard]] Shape* modify(int id);
+    [[nodiscard]] Snapshot snapshot();
+    // Called once every snapshot taken so far has been destroyed, so the next change need not copy.
+    void snapshotsReleased() { shared = false; }
+    [[nodiscard]] std::size_t orderOf(int id) const { return positions.at(id); }
+    [[nodiscard]] std::int64_t sequenceOf(int id) const { return (*slots)[positions.at(id)].sequence; }
+    [[nodiscard]] std::size_t size() const { return positions.size(); }
+    [[nodiscard]] bool empty() const { return positions.empty(); }
+
+    [[nodiscard]] const_iterator begin() const { return {slots->data(), slots->data() + slots->size()}; }
+    [[nodiscard]] const_iterator end() const { return {slots->data() + slots->size(), slots->data() + slots->size()}; }
+
+private:
+    void detach();
+    void compact();
+
+    std::shared_ptr<std::vector<Slot>> slots = std::make_shared<std::vector<Slot>>();
+    bool shared = false;
+    std::unordered_map<int, std::size_t> positions;
+    std::unordered_map<int, std::size_t> tombstones;
+    std::size_t removedCount = 0;
+    std::int64_t nextSequence = 0;
+};
@@ -0,0 +1,37 @@
+#include "footprint.h"
+#include <algorithm>
+#include <climits>
+#include "figure.h"
+
+bool Footprint::fits(const Shape& shape) {
+    Rect bounds = shape.getBounds();
+    return static_cast<long long>(bounds.bottom) - bounds.top < maxRows &&
+           static_cast<long long>(bounds.right) - bounds.left < INT_MAX;
+}
+
+void Footprint::build(const Shape& shape) {
+    spans.clear();
+    shape.draw(*this, shape.getBounds());
+
+    int anchorX = shape.common().x;
+    int anchorY = shape.common().y;
+    for (Span& span : spans) {
+        span = {span.row - anchorY, span.left - anchorX, span.right - anchorX};
+    }
+    std::sort(spans.begin(), spans.end(), [](const Span& a, const Span& b) {
+        return a.row != b.row ? a.row < b.row : a.left < b.left;
+    });
+
+    // Outlines are recorded cell by cell in places; merge touching runs so each row holds only a few.
+    std::size_t merged = 0;
+    for (const Span& span : spans) {
+        if (merged > 0 && spans[merged - 1].row == span.row && span.left <= spans[merged - 1].right + 1) {
+            spans[merged - 1].right = std::max(spans[merged - 1].right, span.right);
+        }
+        else {
+            spans[merged++] = span;
+        }
+    }
+    spans.resize(merged);
+    spans.shrink_to_fit();
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+#include "framebuffer.h"
+#include "rect.h"
+
+class Shape;
+
+// The cells a figure covers, stored as horizontal runs relative to its anchor and sorted by row.
+// Runs carry no color, so a footprint stays valid when the figure is repainted or moved.
+class Footprint {
+public:
+    struct Span {
+        int row;
+        int left;
+        int right;
+    };
+
+    // Taller figures are rasterized directly on every draw instead of being cached.
+    static constexpr int maxRows = 2048;
+
+    [[nodiscard]] static bool fits(const Shape& shape);
+    void build(const Shape& shape);
+    template<typename Target>
+    void draw(Target& target, const Rect& clip, int anchorX, int anchorY, Framebuffer::Cell cell) const {
+        long long firstRow = static_cast<long long>(clip.top) - anchorY;
+        long long lastRow = static_cast<long long>(clip.bottom) - anchorY;
+        auto it = std::lower_bound(spans.begin(), spans.end(), firstRow, [](const Span& span, long long row) { return span.row < row; });
+        for (; it != spans.end() && it->row <= lastRow; ++it) {
+            long long left = std::max<long long>(static_cast<long long>(anchorX) + it->left, clip.left);
+            long long right = std::min<long long>(static_cast<long long>(anchorX) + it->right, clip.right);
+            if (left <= right) {
+                target.fillSpan(anchorY + it->row, static_cast<int>(left), static_cast<int>(right), cell);
+            }
+        }
+    }
+
+    // Rasterizer interface, in board coordinates; build() rebases the recorded runs onto the anchor.
+    void set(int x, int y, Framebuffer::Cell) { spans.push_back({y, x, x}); }
+    void fillSpan(int row, int left, int right, Framebuffer::Cell) { spans.push_back({row, left, right}); }
+
+private:
+    std::vector<Span> spans;
+};
@@ -0,0 +1,99 @@
+#include "framebuffer.h"
+#include <algorithm>
+#include <cstring>
+
+void Framebuffer::Tile::fillSpan(int row, int left, int right, Cell cell) {
+    std::memset(cells.data() + index(left, row), cell, static_cast<std::size_t>(right - left + 1));
+}
+
+void Framebuffer::Tile::clear(const Rect& region) {
+    for (int row = region.top; row <= region.bottom; ++row) {
+        fillSpan(row, region.left, region.right, emptyCell);
+    }
+}
+
+bool Framebuffer::Tile::empty() const {
+    return std::all_of(cells.begin(), cells.end(), [](Cell cell) { return cell == emptyCell; });
+}
+
+Framebuffer::Framebuffer(const Framebuffer& other) : width(other.width), height(other.height) {
+    for (const auto& [key, tile] : other.tiles) {
+        tiles.emplace(key, std::make_unique<Tile>(*tile));
+    }
+}
+
+Framebuffer& Framebuffer::operator=(const Framebuffer& other) {
+    if (this != &other) {
+        Framebuffer copy(other);
+        width = copy.width;
+        height = copy.height;
+        tiles = std::move(copy.tiles);
+    }
+    return *this;
+}
+
+void Framebuffer::resize(int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+    tiles.clear();
+}
+
+Framebuffer::Cell Framebuffer::at(int x, int y) const {
+    const Tile* tile = findTile(x, y);
+    return tile != nullptr ? tile->at(x, y) : emptyCell;
+}
+
+const Framebuffer::Tile* Framebuffer::findTile(int x, int y) const {
+    auto it = tiles.find(tileKey(x, y));
+    return it != tiles.end() ? it->second.get() : nullptr;
+}
+
+// Probes each tile position in the region, or scans the allocated tiles when there are fewer of them.
+void Framebuffer::findTiles(const Rect& region, std::vector<const Tile*>& found) const {
+    found.clear();
+    if (region.empty()) {
+        return;
+    }
+    long long positions = static_cast<long long>(region.right / tileSize - region.left / tileSize + 1) *
+                          (region.bottom / tileSize - region.top / tileSize + 1);
+    if (positions > static_cast<long long>(tiles.size())) {
+        for (const auto& [key, tile] : tiles) {
+            if (tile->area.intersects(region)) {
+                found.push_back(tile.get());
+            }
+        }
+        return;
+    }
+    for (int top = tileArea(0, region.top).top; top <= region.bottom; top += tileSize) {
+        for (int left = tileArea(region.left, 0).left; left <= region.right; left += tileSize) {
+            if (const Tile* tile = findTile(left, top)) {
+                found.push_back(tile);
+            }
+        }
+    }
+}
+
+void Framebuffer::storeTile(int x, int y, std::unique_ptr<Tile> tile) {
+    if (tile == nullptr) {
+        tiles.erase(tileKey(x, y));
+    }
+    else {
+        tiles[tileKey(x, y)] = std::move(tile);
+    }
+}
+
+void Framebuffer::copyTile(const Framebuffer& source, int x, int y) {
+    const Tile* tile = source.findTile(x, y);
+    storeTile(x, y, tile != nullptr ? std::make_unique<Tile>(*tile) : nullptr);
+}
+
+Rect Framebuffer::tileArea(int x, int y) {
+    int left = x - x % tileSize;
+    int top = y - y % tileSize;
+    return {left, top, left + tileSize - 1, top + tileSize - 1};
+}
+
+std::int64_t Framebuffer::tileKey(int x, int y) {
+    return static_cast<std::int64_t>(static_cast<std::uint64_t>(static_cast<std::uint32_t>(x / tileSize)) << 32 |
+                                     static_cast<std::uint32_t>(y / tileSize));
+}
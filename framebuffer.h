@@ -0,0 +1,62 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "color.h"
+#include "rect.h"
+
+// Sparse board storage: cells live in fixed-size tiles that are only allocated once something is drawn on them.
+class Framebuffer {
+public:
+    using Cell = std::uint8_t;
+    static constexpr Cell emptyCell = 0;
+    static constexpr int tileSize = 64;
+
+    class Tile {
+    public:
+        explicit Tile(const Rect& area) : area(area) { cells.fill(emptyCell); }
+
+        void set(int x, int y, Cell cell) { cells[index(x, y)] = cell; }
+        void fillSpan(int row, int left, int right, Cell cell);
+        void clear(const Rect& region);
+        [[nodiscard]] Cell at(int x, int y) const { return cells[index(x, y)]; }
+        [[nodiscard]] bool empty() const;
+
+        Rect area;
+
+    private:
+        [[nodiscard]] std::size_t index(int x, int y) const {
+            return static_cast<std::size_t>(y - area.top) * tileSize + static_cast<std::size_t>(x - area.left);
+        }
+
+        std::array<Cell, tileSize * tileSize> cells;
+    };
+
+    Framebuffer(int width, int height) : width(width), height(height) {}
+    Framebuffer(const Framebuffer& other);
+    Framebuffer& operator=(const Framebuffer& other);
+
+    void resize(int newWidth, int newHeight);
+    void clear() { tiles.clear(); }
+
+    [[nodiscard]] Cell at(int x, int y) const;
+    [[nodiscard]] const Tile* findTile(int x, int y) const;
+    void findTiles(const Rect& region, std::vector<const Tile*>& found) const;
+    void storeTile(int x, int y, std::unique_ptr<Tile> tile);
+    void copyTile(const Framebuffer& source, int x, int y);
+    [[nodiscard]] static Rect tileArea(int x, int y);
+    [[nodiscard]] std::size_t allocatedTiles() const { return tiles.size(); }
+
+    static Cell encode(const Color& color) { return static_cast<Cell>(static_cast<int>(color.name) + 1); }
+    static Color decode(Cell cell) { return Color(static_cast<ColorName>(cell - 1)); }
+
+    int width;
+    int height;
+
+private:
+    static std::int64_t tileKey(int x, int y);
+
+    std::unordered_map<std::int64_t, std::unique_ptr<Tile>> tiles;
+};
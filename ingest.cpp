@@ -0,0 +1,106 @@
+#include "ingest.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace {
+
+// Spins briefly, then yields, then sleeps, so an idle applier or a blocked producer stops burning a core.
+void backOff(unsigned& attempt) {
+    if (attempt < 64) {
+        std::this_thread::yield();
+    }
+    else {
+        std::this_thread::sleep_for(std::chrono::microseconds(std::min(50u * (attempt - 63), 1000u)));
+    }
+    ++attempt;
+}
+
+}
+
+IngestQueue::IngestQueue(Board& board, std::shared_mutex* boardMutex, std::size_t capacity, std::size_t maxBatch)
+        : board(board), boardMutex(boardMutex), queue(capacity), maxBatch(std::max<std::size_t>(maxBatch, 1)), applier([this] { applyLoop(); }) {}
+
+IngestQueue::~IngestQueue() {
+    flush();
+    stopping = true;
+    applier.join();
+}
+
+bool IngestQueue::tryPush(const Board::Operation& operation) {
+    if (!queue.tryPush(operation)) {
+        refusedPushes.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    pushed.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void IngestQueue::push(const Board::Operation& operation) {
+    if (queue.tryPush(operation)) {
+        pushed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    unsigned attempt = 0;
+    do {
+        backOff(attempt);
+    } while (!queue.tryPush(operation));
+    pushed.fetch_add(1, std::memory_order_relaxed);
+    stalledPushes.fetch_add(1, std::memory_order_relaxed);
+    stallNanoseconds.fetch_add(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count()), std::memory_order_relaxed);
+}
+
+// Waits on the queue's own positions rather than on pushed, which a producer bumps only after its operation
+// is already in the queue: the position is claimed before the push returns, so nothing returned is missed.
+void IngestQueue::flush() {
+    std::uint64_t target = queue.enqueued();
+    unsigned attempt = 0;
+    while (processed.load(std::memory_order_acquire) < target) {
+        backOff(attempt);
+    }
+}
+
+IngestQueue::Metrics IngestQueue::metrics() const {
+    return {pushed.load(std::memory_order_relaxed), applied.load(std::memory_order_relaxed), rejected.load(std::memory_order_relaxed),
+            batches.load(std::memory_order_relaxed), queue.size(), maxDepth.load(std::memory_order_relaxed),
+            refusedPushes.load(std::memory_order_relaxed), stalledPushes.load(std::memory_order_relaxed),
+            stallNanoseconds.load(std::memory_order_relaxed)};
+}
+
+void IngestQueue::applyLoop() {
+    std::vector<Board::Operation> batch;
+    batch.reserve(maxBatch);
+    unsigned attempt = 0;
+    while (true) {
+        std::size_t depth = queue.size();
+        if (depth > maxDepth.load(std::memory_order_relaxed)) {
+            maxDepth.store(depth, std::memory_order_relaxed);
+        }
+
+        batch.clear();
+        if (queue.popBatch(batch, maxBatch) == 0) {
+            if (stopping) {
+                return;
+            }
+            backOff(attempt);
+            continue;
+        }
+        attempt = 0;
+
+        Board::BatchOutcome outcome;
+        {
+            std::unique_lock<std::shared_mutex> lock;
+            if (boardMutex != nullptr) {
+                lock = std::unique_lock<std::shared_mutex>(*boardMutex);
+            }
+            outcome = board.applyBatch(batch);
+        }
+        applied.fetch_add(outcome.applied, std::memory_order_relaxed);
+        rejected.fetch_add(batch.size() - outcome.applied, std::memory_order_relaxed);
+        batches.fetch_add(1, std::memory_order_relaxed);
+        processed.fetch_add(batch.size(), std::memory_order_release);
+    }
+}
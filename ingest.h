@@ -0,0 +1,62 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <thread>
+#include "board.h"
+#include "mpsc_queue.h"
+
+// Feeds add, move and paint operations from any number of producer threads into one board. Producers push
+// into a bounded lock-free queue; a single applier thread drains it in batches of up to maxBatch and hands
+// each batch to Board::applyBatch. Without a mutex the board belongs to the applier while the queue exists:
+// other code may only touch it after flush() returns and before the next push. Given one, the applier holds
+// it exclusively for each batch, and other code may use the board whenever it holds the mutex too.
+class IngestQueue {
+public:
+    struct Metrics {
+        std::uint64_t pushed;
+        std::uint64_t applied;
+        std::uint64_t rejected;
+        std::uint64_t batches;
+        std::size_t depth;
+        std::size_t maxDepth;
+        // Backpressure: tryPush calls refused because the queue was full, and push calls that had to wait.
+        std::uint64_t refusedPushes;
+        std::uint64_t stalledPushes;
+        std::uint64_t stallNanoseconds;
+    };
+
+    explicit IngestQueue(Board& board, std::shared_mutex* boardMutex = nullptr, std::size_t capacity = 1 << 16, std::size_t maxBatch = 4096);
+    // Applies everything already pushed before stopping the applier.
+    ~IngestQueue();
+    IngestQueue(const IngestQueue&) = delete;
+    IngestQueue& operator=(const IngestQueue&) = delete;
+
+    // Returns false at once when the queue is full.
+    bool tryPush(const Board::Operation& operation);
+    // Waits for room when the queue is full.
+    void push(const Board::Operation& operation);
+    // Waits until every operation pushed before the call has been applied.
+    void flush();
+    [[nodiscard]] Metrics metrics() const;
+
+private:
+    void applyLoop();
+
+    Board& board;
+    std::shared_mutex* boardMutex;
+    BoundedMpscQueue<Board::Operation> queue;
+    std::size_t maxBatch;
+    std::atomic<bool> stopping{false};
+    std::atomic<std::uint64_t> pushed{0};
+    std::atomic<std::uint64_t> processed{0};
+    std::atomic<std::uint64_t> applied{0};
+    std::atomic<std::uint64_t> rejected{0};
+    std::atomic<std::uint64_t> batches{0};
+    std::atomic<std::size_t> maxDepth{0};
+    std::atomic<std::uint64_t> refusedPushes{0};
+    std::atomic<std::uint64_t> stalledPushes{0};
+    std::atomic<std::uint64_t> stallNanoseconds{0};
+    std::thread applier;
+};
@@ -0,0 +1,216 @@
+#include "journal.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include "figure.h"
+#include "profiler.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+JournalRecord JournalRecord::put(int id, const Shape& shape, std::int64_t sequence) {
+    JournalRecord record{};
+    record.op = Op::Put;
+    record.sequence = sequence;
+    record.figure = toSceneRecord(id, shape);
+    return record;
+}
+
+JournalRecord JournalRecord::update(int id, const Shape& shape) {
+    JournalRecord record{};
+    record.op = Op::Update;
+    record.figure = toSceneRecord(id, shape);
+    return record;
+}
+
+JournalRecord JournalRecord::remove(int id) {
+    JournalRecord record{};
+    record.op = Op::Remove;
+    record.figure.id = id;
+    return record;
+}
+
+JournalRecord JournalRecord::clear() {
+    JournalRecord record{};
+    record.op = Op::Clear;
+    return record;
+}
+
+JournalRecord JournalRecord::resize(int width, int height) {
+    JournalRecord record{};
+    record.op = Op::Resize;
+    record.figure.param1 = width;
+    record.figure.param2 = height;
+    return record;
+}
+
+// FNV-1a over every byte of the record except the checksum itself.
+std::uint32_t JournalRecord::computeChecksum() const {
+    unsigned char bytes[sizeof(JournalRecord)];
+    std::memcpy(bytes, this, sizeof(bytes));
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < sizeof(bytes); ++i) {
+        if (i < offsetof(JournalRecord, checksum) || i >= offsetof(JournalRecord, checksum) + sizeof(checksum)) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+namespace {
+
+#ifdef _WIN32
+
+bool syncFile(const std::string& filePath) {
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    bool synced = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+    return synced;
+}
+
+// NTFS journals its own metadata, so a completed rename does not need the directory flushed.
+bool syncDirectoryOf(const std::string&) {
+    return true;
+}
+
+#else
+
+// Any descriptor for the file flushes all of its written data, including what the ofstream wrote.
+bool syncFile(const std::string& filePath) {
+    int descriptor = ::open(filePath.c_str(), O_WRONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    bool synced = ::fsync(descriptor) == 0;
+    ::close(descriptor);
+    return synced;
+}
+
+// A rename is only durable once the directory holding the name is synced. Some file systems cannot sync
+// a directory at all and say so with EINVAL; there is nothing more to do on those.
+bool syncDirectoryOf(const std::string& filePath) {
+    std::filesystem::path directory = std::filesystem::path(filePath).parent_path();
+    int descriptor = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+    bool synced = ::fsync(descriptor) == 0 || errno == EINVAL;
+    ::close(descriptor);
+    return synced;
+}
+
+#endif
+
+bool writeRecords(std::ofstream& output, const std::vector<JournalRecord>& records) {
+    for (JournalRecord record : records) {
+        record.checksum = record.computeChecksum();
+        output.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    output.flush();
+    Profiler::countBytes(records.size() * sizeof(JournalRecord));
+    return static_cast<bool>(output);
+}
+
+}
+
+// The new journal is written next to the old one, synced, and renamed over it, so a crash during a
+// checkpoint leaves one complete journal or the other.
+bool Journal::checkpoint(const std::string& filePath, const std::vector<JournalRecord>& records) {
+    close();
+    std::string temporaryPath = filePath + ".tmp";
+    {
+        std::ofstream output(temporaryPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!output.is_open()) {
+            return false;
+        }
+        JournalHeader header{};
+        std::copy(std::begin(JournalHeader::expectedMagic), std::end(JournalHeader::expectedMagic), header.magic);
+        header.version = JournalHeader::currentVersion;
+        header.recordSize = sizeof(JournalRecord);
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        Profiler::countBytes(sizeof(header));
+        if (!writeRecords(output, records)) {
+            return false;
+        }
+    }
+    if (!syncFile(temporaryPath)) {
+        return false;
+    }
+
+    std::error_code renameError;
+    std::filesystem::rename(temporaryPath, filePath, renameError);
+    if (renameError || !syncDirectoryOf(filePath)) {
+        return false;
+    }
+    file.open(filePath, std::ios::out | std::ios::binary | std::ios::app);
+    path = filePath;
+    appended = 0;
+    return file.is_open();
+}
+
+bool Journal::append(const std::vector<JournalRecord>& records) {
+    if (!writeRecords(file, records) || !syncFile(path)) {
+        return false;
+    }
+    appended += records.size();
+    return true;
+}
+
+void Journal::close() {
+    if (file.is_open()) {
+        file.close();
+    }
+    file.clear();
+    appended = 0;
+}
+
+bool Journal::read(const std::string& filePath, std::vector<JournalRecord>& records, bool& damagedTail, std::string& failure) {
+    MappedFile mapped(filePath);
+    if (!mapped.isOpen()) {
+        failure = "Could not open journal " + filePath + " for reading.";
+        return false;
+    }
+    if (mapped.readError()) {
+        failure = "Could not read journal " + filePath + ": " + mapped.readError().message() + ".";
+        return false;
+    }
+
+    JournalHeader header{};
+    if (mapped.size() < sizeof(header)) {
+        failure = filePath + " is not a journal file.";
+        return false;
+    }
+    std::memcpy(&header, mapped.data(), sizeof(header));
+    if (!std::equal(std::begin(header.magic), std::end(header.magic), JournalHeader::expectedMagic)) {
+        failure = filePath + " is not a journal file.";
+        return false;
+    }
+    if (header.version != JournalHeader::currentVersion || header.recordSize != sizeof(JournalRecord)) {
+        failure = "Unsupported journal version " + std::to_string(header.version) + ".";
+        return false;
+    }
+
+    std::size_t count = (mapped.size() - sizeof(header)) / sizeof(JournalRecord);
+    damagedTail = (mapped.size() - sizeof(header)) % sizeof(JournalRecord) != 0;
+    records.clear();
+    records.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        JournalRecord record;
+        std::memcpy(&record, mapped.data() + sizeof(header) + i * sizeof(JournalRecord), sizeof(record));
+        if (record.checksum != record.computeChecksum()) {
+            damagedTail = true;
+            break;
+        }
+        records.push_back(record);
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "scene_file.h"
+
+// One change to the board as it is written to the journal: the state it leaves behind, never the
+// state it replaced, so replaying records in order rebuilds the board.
+struct JournalRecord {
+    enum class Op : std::uint8_t {
+        Put,
+        Update,
+        Remove,
+        Clear,
+        Resize
+    };
+
+    Op op;
+    std::uint8_t reserved[3];
+    std::uint32_t checksum;
+    std::int64_t sequence;
+    SceneRecord figure;
+
+    static JournalRecord put(int id, const Shape& shape, std::int64_t sequence);
+    static JournalRecord update(int id, const Shape& shape);
+    static JournalRecord remove(int id);
+    static JournalRecord clear();
+    static JournalRecord resize(int width, int height);
+
+    [[nodiscard]] std::uint32_t computeChecksum() const;
+};
+
+struct JournalHeader {
+    static constexpr char expectedMagic[4] = {'S', 'C', 'N', 'J'};
+    static constexpr std::uint32_t currentVersion = 1;
+
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint32_t reserved;
+};
+
+static_assert(sizeof(JournalRecord) == 40, "JournalRecord layout is part of the file format");
+static_assert(sizeof(JournalHeader) == 16, "JournalHeader layout is part of the file format");
+
+// Append-only log of board changes. Every append is synced to disk before the command finishes, so it
+// survives a power loss or an operating system crash as well as the program dying; a checkpoint replaces
+// the whole file with the records that recreate the current board, which bounds replay time.
+class Journal {
+public:
+    [[nodiscard]] bool isOpen() const { return file.is_open(); }
+    [[nodiscard]] const std::string& getPath() const { return path; }
+    [[nodiscard]] std::size_t recordsSinceCheckpoint() const { return appended; }
+
+    bool checkpoint(const std::string& filePath, const std::vector<JournalRecord>& records);
+    bool append(const std::vector<JournalRecord>& records);
+    void close();
+
+    // Reads every intact record. Reading stops quietly at a torn or corrupt record, which is what a crash
+    // in the middle of an append leaves behind; damagedTail tells whether that happened.
+    static bool read(const std::string& filePath, std::vector<JournalRecord>& records, bool& damagedTail, std::string& failure);
+
+private:
+    std::string path;
+    std::ofstream file;
+    std::size_t appended = 0;
+};
@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+// Compile-time perfect hash from keywords to enum values. The constructor searches for a seed under
+// which every keyword lands in its own slot, so a lookup is one hash and at most one comparison.
+template<typename Enum, std::size_t Count, bool IgnoreCase = false>
+class KeywordTable {
+public:
+    using Entry = std::pair<std::string_view, Enum>;
+
+    constexpr KeywordTable(const std::array<Entry, Count>& entries, Enum missing) : entries(entries), missing(missing) {
+        while (!tryFill()) {
+            ++seed;
+        }
+    }
+
+    [[nodiscard]] constexpr Enum find(std::string_view word) const {
+        std::size_t slot = slots[slotOf(word, seed)];
+        return slot != 0 && equal(entries[slot - 1].first, word) ? entries[slot - 1].second : missing;
+    }
+
+    [[nodiscard]] constexpr const std::array<Entry, Count>& keywords() const { return entries; }
+
+private:
+    static constexpr std::size_t slotCount = [] {
+        std::size_t size = 1;
+        while (size < Count * 2) {
+            size *= 2;
+        }
+        return size;
+    }();
+
+    static constexpr char fold(char c) {
+        return IgnoreCase && c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    static constexpr bool equal(std::string_view keyword, std::string_view word) {
+        if (keyword.size() != word.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < word.size(); ++i) {
+            if (keyword[i] != fold(word[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static constexpr std::size_t slotOf(std::string_view word, std::uint32_t seed) {
+        std::uint32_t hash = 2166136261u ^ seed;
+        for (char c : word) {
+            hash = (hash ^ static_cast<unsigned char>(fold(c))) * 16777619u;
+        }
+        return (hash ^ (hash >> 16)) & (slotCount - 1);
+    }
+
+    constexpr bool tryFill() {
+        for (auto& slot : slots) {
+            slot = 0;
+        }
+        for (std::size_t i = 0; i < Count; ++i) {
+            std::size_t& slot = slots[slotOf(entries[i].first, seed)];
+            if (slot != 0) {
+                return false;
+            }
+            slot = i + 1;
+        }
+        return true;
+    }
+
+    std::array<Entry, Count> entries;
+    Enum missing;
+    std::uint32_t seed = 0;
+    // Index + 1 of the keyword in each slot; 0 marks an empty slot.
+    std::array<std::size_t, slotCount> slots{};
+};
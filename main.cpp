@@ -1,132 +1,101 @@
 #include "board.h"
+#include <csignal>
+#include <fstream>
 #include <iostream>
-#include <sstream>
-#include "enums.h"
+#include "command.h"
+#include "server.h"
+#include "tokenizer.h"
 
-int main() {
-    Board board;
-    std::string input;
-
-    while (true) {
-        std::cout << "\nEnter command (draw/list/shapes/add/select/remove/edit/paint/move/clear/save/load/exit): " << std::endl;
-        std::getline(std::cin, input);
+namespace {
 
-        std::istringstream iss(input);
-        std::string command;
-        iss >> command;
+int runBatch(Board& board, const std::string& scriptPath, bool quiet) {
+    std::ios::sync_with_stdio(false);
+    static char outputBuffer[1 << 20];
+    std::cout.rdbuf()->pubsetbuf(outputBuffer, sizeof(outputBuffer));
+    board.setOutput(std::cout, std::cerr);
+    board.setQuiet(quiet);
 
-        auto cmd = commandMap.find(command);
-        if (cmd != commandMap.end()) {
-            CommandType commandType = cmd->second;
-            switch (commandType) {
-                case CommandType::Draw: {
-                    board.draw();
-                    break;
-                }
-                case CommandType::List: {
-                    board.list();
-                    break;
-                }
-                case CommandType::Shapes: {
-                    Board::shapes();
-                    break;
-                }
-                case CommandType::Add: {
-                    std::string fillModeStr, colorStr, shapeNameStr;
-                    int x, y, param1, param2 = 0;
-                    iss >> fillModeStr >> colorStr >> shapeNameStr >> x >> y >> param1;
+    int failedLines;
+    if (scriptPath.empty() || scriptPath == "-") {
+        failedLines = runScript(board, std::cin);
+    }
+    else {
+        std::ifstream script(scriptPath);
+        if (!script.is_open()) {
+            std::cerr << "Could not open script " << scriptPath << "." << std::endl;
+            return 2;
+        }
+        failedLines = runScript(board, script);
+    }
 
-                    auto shapeTypeIt = shapeTypeMap.find(shapeNameStr);
-                    if (shapeTypeIt == shapeTypeMap.end()) {
-                        std::cout << "Invalid shape type." << std::endl;
-                        continue;
-                    }
-                    ShapeType shapeType = shapeTypeIt->second;
+    std::cout.flush();
+    if (failedLines > 0) {
+        std::cerr << failedLines << " command(s) failed." << std::endl;
+        return 1;
+    }
+    return 0;
+}
 
-                    if (shapeType == ShapeType::Rectangle || shapeType == ShapeType::Line) {
-                        if (!(iss >> param2)) {
-                            std::cout << "Invalid parameters for " << shapeNameStr << ". Needs an additional parameter." << std::endl;
-                            continue;
-                        }
-                    }
+void stopServer(int) {
+    Server::requestStop();
+}
 
-                    FillMode fillMode = (fillModeStr == "fill") ? FillMode::Fill : FillMode::Frame;
+int runServer(const std::string& socketPath, int threadCount) {
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    Server server(socketPath, static_cast<std::size_t>(threadCount));
+    return server.run() ? 0 : 2;
+}
 
-                    ColorName color = Color::fromString(colorStr);
-                    if (color == ColorName::Invalid) {
-                        std::cout << "Invalid color." << std::endl;
-                        continue;
-                    }
+}
 
-                    board.add(shapeType, color, x, y, param1, param2, fillMode);
-                    break;
-                }
-                case CommandType::Clear: {
-                    board.clear(board.getFilePath());
-                    break;
-                }
-                case CommandType::Save: {
-                    board.save(board.getFilePath());
-                    break;
-                }
-                case CommandType::Load: {
-                    board.load(board.getFilePath());
-                    break;
-                }
-                case CommandType::Select: {
-                    int firstParam;
-                    if (iss >> firstParam) {
-                        if (iss.peek() == ',' || iss.peek() == ' ') {
-                            int x = firstParam, y;
-                            iss >> y;
-                            board.select(x, y);
-                        }
-                        else {
-                            board.select(firstParam);
-                        }
-                    }
-                    else {
-                        std::cout << "Invalid select command. Please provide either an ID or coordinates." << std::endl;
-                    }
-                    break;
-                }
-                case CommandType::Remove: {
-                    board.remove();
-                    break;
-                }
-                case CommandType::Edit: {
-                    int x, y, param1, param2 = 0;
-                    std::string color, fillModeStr;
-                    if (!(iss >> x >> y >> param1 >> param2 >> color >> fillModeStr)) {
-                        std::cout << "Invalid parameters for edit command. Expected format: edit x y param1 param2 color fillMode" << std::endl;
-                        continue;
-                    }
-                    board.edit(x, y, param1, param2, color, fillModeStr);
-                    break;
-                }
-                case CommandType::Paint: {
-                    std::string color;
-                    iss >> color;
-                    board.paint(color);
-                    break;
-                }
-                case CommandType::Move: {
-                    int x, y;
-                    iss >> x >> y;
-                    board.move(x, y);
-                    break;
-                }
-                case CommandType::Exit: {
-                    std::cout << "Exiting the program." << std::endl;
-                    return 0;
-                }
-                case CommandType::Invalid:
-                    break;
-            }
+int main(int argc, char* argv[]) {
+    bool batch = false;
+    bool quiet = false;
+    std::string scriptPath;
+    std::string socketPath;
+    int threadCount = 32;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--serve" && i + 1 < argc) {
+            socketPath = argv[++i];
+        }
+        else if (argument == "--threads" && i + 1 < argc && Tokenizer::parseInt(argv[i + 1], threadCount) && threadCount > 0) {
+            ++i;
+        }
+        else if (argument == "--batch") {
+            batch = true;
+        }
+        else if (argument == "--quiet") {
+            quiet = true;
+        }
+        else if (argument.size() > 1 && argument[0] == '-') {
+            std::cerr << "Unknown option " << argument << ". Usage: " << argv[0] << " [--batch] [--quiet] [script|-] | --serve socket [--threads N]" << std::endl;
+            return 2;
         }
         else {
-            std::cout << "Unknown command." << std::endl;
+            batch = true;
+            scriptPath = argument;
+        }
+    }
+
+    if (!socketPath.empty()) {
+        return runServer(socketPath, threadCount);
+    }
+
+    Board board;
+    if (batch) {
+        return runBatch(board, scriptPath, quiet);
+    }
+    board.setQuiet(quiet);
+
+    std::string input;
+    while (true) {
+        std::cout << "\nEnter command (draw/list/shapes/add/select/remove/edit/paint/move/undo/redo/resize/display/viewport/clear/save/load/journal/recover/stats/exit): " << std::endl;
+        if (!std::getline(std::cin, input) || !executeCommand(board, input)) {
+            break;
         }
     }
-    //return 0;
-}
\ No newline at end of file
+    board.finishBackgroundSave();
+    return 0;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bounded lock-free queue for many producers and a single consumer. Each cell carries a sequence number
+// that tells producers whether it is free for the lap they are on and tells the consumer whether it has
+// been filled, so a push costs one compare-and-swap on the tail and a pop none at all.
+template<typename T>
+class BoundedMpscQueue {
+public:
+    // The capacity is rounded up to a power of two.
+    explicit BoundedMpscQueue(std::size_t capacity) : mask(roundUp(capacity) - 1), cells(new Cell[mask + 1]) {
+        for (std::size_t i = 0; i <= mask; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedMpscQueue(const BoundedMpscQueue&) = delete;
+    BoundedMpscQueue& operator=(const BoundedMpscQueue&) = delete;
+
+    // Returns false without waiting when the queue is full.
+    bool tryPush(const T& value) {
+        std::size_t position = tail.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[position & mask];
+            std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto lap = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+            if (lap == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (lap < 0) {
+                return false;
+            }
+            else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer only. Moves up to maxCount values into out, stopping at the first cell a producer has
+    // claimed but not finished writing; returns how many were taken.
+    std::size_t popBatch(std::vector<T>& out, std::size_t maxCount) {
+        std::size_t position = head.load(std::memory_order_relaxed);
+        std::size_t count = 0;
+        for (; count < maxCount; ++count, ++position) {
+            Cell& cell = cells[position & mask];
+            if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+                break;
+            }
+            out.push_back(std::move(cell.value));
+            cell.sequence.store(position + mask + 1, std::memory_order_release);
+        }
+        head.store(position, std::memory_order_relaxed);
+        return count;
+    }
+
+    // Positions claimed by producers so far. Every push that has returned true is below it, though the
+    // last few may still be being written.
+    [[nodiscard]] std::size_t enqueued() const { return tail.load(std::memory_order_acquire); }
+
+    // Approximate while producers are pushing; never more than the capacity.
+    [[nodiscard]] std::size_t size() const {
+        std::size_t taken = head.load(std::memory_order_relaxed);
+        std::size_t claimed = tail.load(std::memory_order_relaxed);
+        return claimed > taken ? std::min(claimed - taken, capacity()) : 0;
+    }
+    [[nodiscard]] std::size_t capacity() const { return mask + 1; }
+
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    static std::size_t roundUp(std::size_t capacity) {
+        std::size_t rounded = 2;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        return rounded;
+    }
+
+    const std::size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    // Kept on separate cache lines so producers claiming cells do not slow the consumer down.
+    alignas(64) std::atomic<std::size_t> tail{0};
+    alignas(64) std::atomic<std::size_t> head{0};
+};
@@ -0,0 +1,171 @@
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include "allocation_counter.h"
+
+namespace {
+
+std::atomic<std::uint64_t> byteCount{0};
+
+std::uint64_t nanosecondsBetween(Profiler::Clock::time_point from, Profiler::Clock::time_point to) {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+}
+
+std::size_t bucketOf(std::uint64_t nanoseconds) {
+    std::size_t bucket = 0;
+    while (nanoseconds > 1 && bucket + 1 < Profiler::bucketCount) {
+        nanoseconds >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+}
+
+std::uint64_t Profiler::Section::percentile(double fraction) const {
+    auto wanted = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(static_cast<double>(calls) * fraction)));
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < bucketCount; ++bucket) {
+        seen += histogram[bucket];
+        if (seen >= wanted) {
+            return std::min(std::uint64_t{2} << bucket, maxNanoseconds);
+        }
+    }
+    return maxNanoseconds;
+}
+
+Profiler::Scope::Scope(Profiler& profiler, std::string_view group, std::string_view name)
+        : profiler(profiler.isEnabled() ? &profiler : nullptr), group(group) {
+    if (this->profiler != nullptr) {
+        start(name);
+    }
+}
+
+Profiler::Scope::~Scope() {
+    if (profiler != nullptr) {
+        stop();
+    }
+}
+
+void Profiler::Scope::next(std::string_view name) {
+    if (profiler != nullptr) {
+        stop();
+        start(name);
+    }
+}
+
+void Profiler::Scope::start(std::string_view name) {
+    key.assign(group).append(".").append(name);
+    allocationsAtStart = allocationCount();
+    bytesAtStart = byteCount.load(std::memory_order_relaxed);
+    started = Clock::now();
+}
+
+void Profiler::Scope::stop() {
+    profiler->record(key, started, allocationCount() - allocationsAtStart,
+                     byteCount.load(std::memory_order_relaxed) - bytesAtStart);
+}
+
+Profiler::~Profiler() {
+    disable();
+}
+
+void Profiler::enable() {
+    if (!enabled) {
+        enabled = true;
+        startCountingAllocations();
+        if (sections.empty()) {
+            origin = Clock::now();
+        }
+    }
+}
+
+void Profiler::disable() {
+    if (enabled) {
+        enabled = false;
+        stopCountingAllocations();
+    }
+}
+
+void Profiler::reset() {
+    sections.clear();
+    events.clear();
+    droppedEvents = 0;
+    origin = Clock::now();
+}
+
+void Profiler::countBytes(std::size_t bytes) {
+    byteCount.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void Profiler::record(const std::string& key, Clock::time_point started, std::uint64_t allocations, std::uint64_t bytes) {
+    Clock::time_point stopped = Clock::now();
+    std::uint64_t elapsed = nanosecondsBetween(started, stopped);
+
+    auto it = sections.find(key);
+    if (it == sections.end()) {
+        it = sections.emplace(key, Section{}).first;
+    }
+    Section& section = it->second;
+    ++section.calls;
+    section.totalNanoseconds += elapsed;
+    section.maxNanoseconds = std::max(section.maxNanoseconds, elapsed);
+    section.allocations += allocations;
+    section.bytesWritten += bytes;
+    ++section.histogram[bucketOf(elapsed)];
+
+    if (events.size() < maxTraceEvents) {
+        events.push_back({&it->first, static_cast<std::int64_t>(nanosecondsBetween(origin, started)), static_cast<std::int64_t>(elapsed)});
+    }
+    else {
+        ++droppedEvents;
+    }
+}
+
+void Profiler::report(std::ostream& output) const {
+    auto microseconds = [](std::uint64_t nanoseconds) { return static_cast<double>(nanoseconds) / 1000.0; };
+
+    std::ios::fmtflags flags = output.flags();
+    output << std::left << std::setw(20) << "section" << std::right << std::setw(9) << "calls" << std::setw(12) << "total ms"
+           << std::setw(11) << "mean us" << std::setw(11) << "p50 us" << std::setw(11) << "p90 us" << std::setw(11) << "p99 us"
+           << std::setw(11) << "max us" << std::setw(11) << "allocs" << std::setw(12) << "bytes" << '\n';
+    output << std::fixed << std::setprecision(1);
+    for (const auto& [name, section] : sections) {
+        output << std::left << std::setw(20) << name << std::right << std::setw(9) << section.calls
+               << std::setw(12) << microseconds(section.totalNanoseconds) / 1000.0
+               << std::setw(11) << microseconds(section.totalNanoseconds / section.calls)
+               << std::setw(11) << microseconds(section.percentile(0.5))
+               << std::setw(11) << microseconds(section.percentile(0.9))
+               << std::setw(11) << microseconds(section.percentile(0.99))
+               << std::setw(11) << microseconds(section.maxNanoseconds)
+               << std::setw(11) << section.allocations << std::setw(12) << section.bytesWritten << '\n';
+    }
+    output.flags(flags);
+    if (droppedEvents > 0) {
+        output << droppedEvents << " calls were not kept for the trace.\n";
+    }
+}
+
+bool Profiler::writeTrace(const std::string& filePath) const {
+    std::ofstream output(filePath, std::ios::out | std::ios::trunc);
+    if (!output.is_open()) {
+        return false;
+    }
+
+    // Trace timestamps are in microseconds; all sections run on the command thread.
+    output << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    output << std::fixed << std::setprecision(3);
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        const TraceEvent& event = events[i];
+        std::string_view name = *event.name;
+        output << (i == 0 ? "\n" : ",\n") << "{\"name\":\"" << name << "\",\"cat\":\"" << name.substr(0, name.find('.'))
+               << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << static_cast<double>(event.start) / 1000.0
+               << ",\"dur\":" << static_cast<double>(event.duration) / 1000.0 << "}";
+    }
+    output << "\n]}\n";
+    return static_cast<bool>(output);
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Opt-in timing of named sections such as "command.add" or "draw.rasterize". Each section keeps its call
+// count, a latency histogram, and the heap allocations and bytes written while it ran; while enabled every
+// call is also kept as a trace event. Sections are timed on the command thread only, but the allocation
+// and byte counters are process-wide, so work running on other threads meanwhile is counted too.
+class Profiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Bucket i counts calls that took from 2^i up to 2^(i+1) nanoseconds; the last one also takes everything slower.
+    static constexpr std::size_t bucketCount = 40;
+    static constexpr std::size_t maxTraceEvents = 1 << 20;
+
+    struct Section {
+        std::uint64_t calls = 0;
+        std::uint64_t totalNanoseconds = 0;
+        std::uint64_t maxNanoseconds = 0;
+        std::uint64_t allocations = 0;
+        std::uint64_t bytesWritten = 0;
+        std::array<std::uint64_t, bucketCount> histogram{};
+
+        // Upper bound of the histogram bucket holding the given fraction of calls, capped at the slowest call.
+        [[nodiscard]] std::uint64_t percentile(double fraction) const;
+    };
+
+    // Times one section from construction to destruction. Does nothing when the profiler is off.
+    class Scope {
+    public:
+        Scope(Profiler& profiler, std::string_view group, std::string_view name);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        // Ends the current section and starts timing the next phase of the same group.
+        void next(std::string_view name);
+
+    private:
+        void start(std::string_view name);
+        void stop();
+
+        Profiler* profiler;
+        std::string_view group;
+        std::string key;
+        Clock::time_point started;
+        std::uint64_t allocationsAtStart = 0;
+        std::uint64_t bytesAtStart = 0;
+    };
+
+    Profiler() = default;
+    ~Profiler();
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    [[nodiscard]] bool isEnabled() const { return enabled; }
+    void enable();
+    void disable();
+    void reset();
+
+    void report(std::ostream& output) const;
+    // Writes the recorded calls in the Chrome trace event format, for chrome://tracing or Perfetto.
+    [[nodiscard]] bool writeTrace(const std::string& filePath) const;
+
+    // Frames sent to the terminal and scene and journal files being written report their size here.
+    static void countBytes(std::size_t bytes);
+
+private:
+    struct TraceEvent {
+        const std::string* name;
+        std::int64_t start;
+        std::int64_t duration;
+    };
+
+    void record(const std::string& key, Clock::time_point started, std::uint64_t allocations, std::uint64_t bytes);
+
+    bool enabled = false;
+    std::map<std::string, Section, std::less<>> sections;
+    std::vector<TraceEvent> events;
+    std::size_t droppedEvents = 0;
+    Clock::time_point origin;
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include <algorithm>
+
+struct Rect {
+    int left = 0;
+    int top = 0;
+    int right = -1;
+    int bottom = -1;
+
+    [[nodiscard]] bool empty() const { return left > right || top > bottom; }
+    [[nodiscard]] bool contains(int x, int y) const { return x >= left && x <= right && y >= top && y <= bottom; }
+    [[nodiscard]] bool contains(const Rect& other) const {
+        return other.left >= left && other.right <= right && other.top >= top && other.bottom <= bottom;
+    }
+    [[nodiscard]] bool intersects(const Rect& other) const {
+        return !empty() && !other.empty() && left <= other.right && other.left <= right && top <= other.bottom && other.top <= bottom;
+    }
+    [[nodiscard]] Rect intersected(const Rect& other) const {
+        return {std::max(left, other.left), std::max(top, other.top), std::min(right, other.right), std::min(bottom, other.bottom)};
+    }
+    [[nodiscard]] Rect united(const Rect& other) const {
+        if (empty()) return other;
+        if (other.empty()) return *this;
+        return {std::min(left, other.left), std::min(top, other.top), std::max(right, other.right), std::max(bottom, other.bottom)};
+    }
+};
@@ -0,0 +1,117 @@
+#include "scene_file.h"
+#include "figure.h"
+
+SceneRecord toSceneRecord(int id, const Shape& shape) {
+    const Figure& figure = shape.common();
+    SceneRecord record{};
+    record.id = id;
+    record.x = figure.x;
+    record.y = figure.y;
+    record.param1 = shape.getParam1();
+    record.param2 = shape.getParam2();
+    record.shapeType = static_cast<std::uint8_t>(shape.getType());
+    record.color = static_cast<std::uint8_t>(figure.color.name);
+    record.fillMode = static_cast<std::uint8_t>(figure.fillMode);
+    return record;
+}
+
+bool isWellFormed(const SceneRecord& record) {
+    return record.shapeType < static_cast<std::uint8_t>(ShapeType::Invalid) &&
+           record.color < static_cast<std::uint8_t>(ColorName::Invalid) &&
+           record.fillMode <= static_cast<std::uint8_t>(FillMode::Fill);
+}
+
+Shape toShape(const SceneRecord& record) {
+    return Shape::create(static_cast<ShapeType>(record.shapeType), record.x, record.y, record.param1, record.param2,
+                         Color(static_cast<ColorName>(record.color)), static_cast<FillMode>(record.fillMode));
+}
+
+#ifdef _WIN32
+#include <windows.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    fileHandle = file;
+    opened = true;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        failure.assign(static_cast<int>(GetLastError()), std::system_category());
+        return;
+    }
+    if (fileSize.QuadPart == 0) {
+        return;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        failure.assign(static_cast<int>(GetLastError()), std::system_category());
+        return;
+    }
+    mappingHandle = mapping;
+    bytes = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (bytes != nullptr) {
+        length = static_cast<std::size_t>(fileSize.QuadPart);
+    }
+    else {
+        failure.assign(static_cast<int>(GetLastError()), std::system_category());
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (bytes != nullptr) {
+        UnmapViewOfFile(bytes);
+    }
+    if (mappingHandle != nullptr) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle != nullptr) {
+        CloseHandle(fileHandle);
+    }
+}
+
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) {
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return;
+    }
+    opened = true;
+
+    // A directory opens read-only like a file, but has no contents to map.
+    struct stat info {};
+    if (::fstat(descriptor, &info) != 0) {
+        failure.assign(errno, std::system_category());
+    }
+    else if (S_ISDIR(info.st_mode)) {
+        failure.assign(EISDIR, std::system_category());
+    }
+    else if (info.st_size > 0) {
+        void* mapped = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapped != MAP_FAILED) {
+            bytes = static_cast<const char*>(mapped);
+            length = static_cast<std::size_t>(info.st_size);
+            ::madvise(mapped, length, MADV_SEQUENTIAL);
+        }
+        else {
+            failure.assign(errno, std::system_category());
+        }
+    }
+    ::close(descriptor);
+}
+
+MappedFile::~MappedFile() {
+    if (bytes != nullptr) {
+        ::munmap(const_cast<char*>(bytes), length);
+    }
+}
+
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <system_error>
+
+class Shape;
+
+// Binary scene layout: one SceneHeader followed by recordCount SceneRecords, all fields in the
+// writer's native (little-endian on every supported target) byte order.
+struct SceneHeader {
+    static constexpr char expectedMagic[4] = {'S', 'C', 'N', 'B'};
+    static constexpr std::uint32_t currentVersion = 1;
+
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::int32_t boardWidth;
+    std::int32_t boardHeight;
+    std::uint32_t reserved;
+    std::uint64_t recordCount;
+};
+
+struct SceneRecord {
+    std::int32_t id;
+    std::int32_t x;
+    std::int32_t y;
+    std::int32_t param1;
+    std::int32_t param2;
+    std::uint8_t shapeType;
+    std::uint8_t color;
+    std::uint8_t fillMode;
+    std::uint8_t reserved;
+};
+
+static_assert(sizeof(SceneHeader) == 32, "SceneHeader layout is part of the file format");
+static_assert(sizeof(SceneRecord) == 24, "SceneRecord layout is part of the file format");
+
+[[nodiscard]] SceneRecord toSceneRecord(int id, const Shape& shape);
+// Checks that the enum fields name a shape type, color and fill mode; toShape() relies on it.
+[[nodiscard]] bool isWellFormed(const SceneRecord& record);
+[[nodiscard]] Shape toShape(const SceneRecord& record);
+
+// Read-only view of a whole file, mapped into memory where the platform allows it.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    [[nodiscard]] bool isOpen() const { return opened; }
+    // Set when the file opened but its size or contents could not be read; size() is then 0.
+    [[nodiscard]] const std::error_code& readError() const { return failure; }
+    [[nodiscard]] const char* data() const { return bytes; }
+    [[nodiscard]] std::size_t size() const { return length; }
+
+private:
+    const char* bytes = nullptr;
+    std::size_t length = 0;
+    bool opened = false;
+    std::error_code failure;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,113 @@
+#include "scene_parser.h"
+#include <algorithm>
+#include <limits>
+#include "enums.h"
+#include "tokenizer.h"
+
+namespace {
+
+ParsedFigure parseLine(std::string_view line, int boardWidth, int boardHeight) {
+    ParsedFigure parsed;
+    Tokenizer tokens(line);
+    std::string_view fillModeStr, colorStr, shapeTypeStr;
+    int x, y, param1;
+    if (!tokens.nextInt(parsed.id) ||
+        (fillModeStr = tokens.next()).empty() ||
+        (colorStr = tokens.next()).empty() ||
+        (shapeTypeStr = tokens.next()).empty() ||
+        !tokens.nextInt(x) || !tokens.nextInt(y) || !tokens.nextInt(param1)) {
+        parsed.status = ParsedFigure::Status::Malformed;
+        return parsed;
+    }
+    // The next free ID is one past the largest loaded, so the largest int cannot be used.
+    if (parsed.id < 0 || parsed.id == std::numeric_limits<int>::max()) {
+        parsed.status = ParsedFigure::Status::InvalidID;
+        return parsed;
+    }
+
+    ColorName colorName = Color::fromString(colorStr);
+    if (colorName == ColorName::Invalid) {
+        parsed.status = ParsedFigure::Status::InvalidColor;
+        parsed.badToken = colorStr;
+        return parsed;
+    }
+
+    ShapeType shapeType = shapeTypeKeywords.find(shapeTypeStr);
+    if (shapeType == ShapeType::Invalid) {
+        parsed.status = ParsedFigure::Status::InvalidShape;
+        parsed.badToken = shapeTypeStr;
+        return parsed;
+    }
+
+    int param2 = 0;
+    if ((shapeType == ShapeType::Rectangle || shapeType == ShapeType::Line) && !tokens.nextInt(param2)) {
+        parsed.status = ParsedFigure::Status::MissingParameters;
+        parsed.badToken = shapeTypeStr;
+        return parsed;
+    }
+    if (shapeType == ShapeType::Circle && param1 <= 0) {
+        parsed.status = ParsedFigure::Status::InvalidRadius;
+        return parsed;
+    }
+
+    FillMode fillMode = (fillModeStr == "fill") ? FillMode::Fill : FillMode::Frame;
+    Shape shape = Shape::create(shapeType, x, y, param1, param2, Color(colorName), fillMode);
+    parsed.key = shape.getKey();
+    if (shape.isOutOfBounds(boardWidth, boardHeight)) {
+        parsed.status = ParsedFigure::Status::OutOfBounds;
+    }
+    return parsed;
+}
+
+}
+
+Shape ParsedFigure::toShape() const {
+    return Shape::create(key.shapeType, key.x, key.y, key.param1, key.param2, Color(key.color), key.fillMode);
+}
+
+std::string ParsedFigure::describeError() const {
+    switch (status) {
+        case Status::InvalidID:
+            return "Error: Invalid figure ID " + std::to_string(id) + " found in file.";
+        case Status::InvalidColor:
+            return "Invalid color specified: " + std::string(badToken);
+        case Status::InvalidShape:
+            return "Error: Invalid shape type " + std::string(badToken) + " found in file. Aborting load.";
+        case Status::MissingParameters:
+            return "Missing parameters for shape " + std::string(badToken);
+        case Status::InvalidRadius:
+            return "Invalid radius for circle.";
+        case Status::OutOfBounds:
+            return "Error: Figure is out of bounds.";
+        default:
+            return {};
+    }
+}
+
+void parseSceneLines(std::string_view text, int boardWidth, int boardHeight, std::vector<ParsedFigure>& out) {
+    while (!text.empty()) {
+        std::size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+
+        if (Tokenizer(line).atEnd()) {
+            continue;
+        }
+        out.push_back(parseLine(line, boardWidth, boardHeight));
+        if (out.back().status != ParsedFigure::Status::Ok) {
+            return;
+        }
+    }
+}
+
+std::vector<std::string_view> splitAtLines(std::string_view text, std::size_t chunkCount) {
+    std::vector<std::string_view> chunks;
+    std::size_t target = text.size() / std::max<std::size_t>(chunkCount, 1) + 1;
+    while (!text.empty()) {
+        std::size_t end = text.size() <= target ? std::string_view::npos : text.find('\n', target);
+        std::size_t length = end == std::string_view::npos ? text.size() : end + 1;
+        chunks.push_back(text.substr(0, length));
+        text.remove_prefix(length);
+    }
+    return chunks;
+}
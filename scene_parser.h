@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "figure.h"
+
+// One line of a text scene, parsed and checked on its own. Checks that need the rest of the file
+// (duplicate figures and IDs) are left to the caller.
+struct ParsedFigure {
+    enum class Status {
+        Ok,
+        Malformed,
+        InvalidID,
+        InvalidColor,
+        InvalidShape,
+        MissingParameters,
+        InvalidRadius,
+        OutOfBounds
+    };
+
+    Status status = Status::Ok;
+    int id = 0;
+    FigureKey key{};
+    std::string_view badToken;
+
+    [[nodiscard]] Shape toShape() const;
+    [[nodiscard]] std::string describeError() const;
+};
+
+// Parses the lines of text in order, stopping after the first line that is not Ok.
+void parseSceneLines(std::string_view text, int boardWidth, int boardHeight, std::vector<ParsedFigure>& out);
+
+// Splits text into roughly chunkCount pieces that each end on a line boundary.
+[[nodiscard]] std::vector<std::string_view> splitAtLines(std::string_view text, std::size_t chunkCount);
@@ -0,0 +1,492 @@
+#include "server.h"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <sstream>
+#include "command.h"
+#include "enums.h"
+#include "tokenizer.h"
+
+namespace {
+
+std::atomic<bool> stopRequested{false};
+
+// Board names become file names, so they are kept to characters that are safe in a path.
+bool isValidBoardName(std::string_view name) {
+    return !name.empty() && name.size() <= 64 && std::all_of(name.begin(), name.end(), [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+    });
+}
+
+}
+
+Server::Server(std::string socketPath, std::size_t threadCount) : socketPath(std::move(socketPath)), workers(threadCount) {}
+
+void Server::requestStop() {
+    stopRequested = true;
+}
+
+Server::SharedBoard& Server::boardNamed(const std::string& name) {
+    std::lock_guard<std::mutex> lock(boardsMutex);
+    auto it = boards.find(name);
+    if (it == boards.end()) {
+        it = boards.emplace(name, std::make_unique<SharedBoard>()).first;
+        it->second->board.setFileStem(name);
+    }
+    return *it->second;
+}
+
+bool Server::handle(Session& session, std::string_view line, std::string& reply) {
+    {
+        std::lock_guard<std::mutex> lock(session.notices->mutex);
+        reply += session.notices->text;
+        session.notices->text.clear();
+    }
+    Tokenizer tokens(line);
+    std::string_view command = tokens.next();
+    if (command.empty()) {
+        return true;
+    }
+    if (command == "exit") {
+        reply += "Exiting the program.\n";
+        return false;
+    }
+    if (command == "board") {
+        std::string_view name = tokens.next();
+        if (!isValidBoardName(name) || !tokens.atEnd()) {
+            reply += "Invalid board name. Use letters, digits, '_' and '-'.\n";
+            return true;
+        }
+        session.shared = &boardNamed(std::string(name));
+        session.selectedID = -1;
+        reply += "Using board " + std::string(name) + ".\n";
+        return true;
+    }
+    if (command == "ingest") {
+        ingest(*session.shared, tokens, reply);
+        return true;
+    }
+    flushIngest(*session.shared);
+    if (read(session, line, reply)) {
+        return true;
+    }
+
+    // Static so the board never points at a stream that is gone, even between commands.
+    static std::ostream discard(nullptr);
+    std::ostringstream output;
+    SharedBoard& shared = *session.shared;
+    std::unique_lock<std::shared_mutex> writing(shared.mutex);
+    shared.board.setOutput(output, output);
+    shared.board.setSaveListener([notices = session.notices](const Board::SaveReport& outcome) {
+        std::lock_guard<std::mutex> lock(notices->mutex);
+        notices->text += outcome.text + '\n';
+    });
+    shared.board.setSelection(session.selectedID);
+    executeCommand(shared.board, line);
+    session.selectedID = shared.board.getSelectedID();
+    shared.board.setOutput(discard, discard);
+    shared.board.setSaveListener(nullptr);
+    writing.unlock();
+    reply += output.str();
+    return true;
+}
+
+IngestQueue& Server::ingestQueueOf(SharedBoard& shared) {
+    std::call_once(shared.ingestStarted, [&shared] {
+        shared.ingest = std::make_unique<IngestQueue>(shared.board, &shared.mutex);
+        shared.ingestReady.store(true, std::memory_order_release);
+    });
+    return *shared.ingest;
+}
+
+void Server::flushIngest(SharedBoard& shared) {
+    if (shared.ingestReady.load(std::memory_order_acquire)) {
+        shared.ingest->flush();
+    }
+}
+
+// Parses one ingest command into a board operation and queues it; the board itself is not touched here.
+void Server::ingest(SharedBoard& shared, Tokenizer& tokens, std::string& reply) {
+    std::string_view action = tokens.next();
+    if (action == "stats" && tokens.atEnd()) {
+        if (!shared.ingestReady.load(std::memory_order_acquire)) {
+            reply += "Nothing has been ingested on this board.\n";
+            return;
+        }
+        IngestQueue::Metrics metrics = shared.ingest->metrics();
+        reply += "Ingested " + std::to_string(metrics.pushed) + " operations: " + std::to_string(metrics.applied) + " applied and " +
+                 std::to_string(metrics.rejected) + " rejected in " + std::to_string(metrics.batches) + " batches. Queue depth " +
+                 std::to_string(metrics.depth) + ", at most " + std::to_string(metrics.maxDepth) + "; " +
+                 std::to_string(metrics.refusedPushes) + " operations refused because the queue was full.\n";
+        return;
+    }
+
+    Board::Operation operation{};
+    operation.shapeType = ShapeType::Invalid;
+    bool valid;
+    if (action == "add") {
+        operation.type = Board::Operation::Type::Add;
+        operation.fillMode = tokens.next() == "fill" ? FillMode::Fill : FillMode::Frame;
+        operation.color = Color::fromString(tokens.next());
+        operation.shapeType = shapeTypeKeywords.find(tokens.next());
+        bool usesParam2 = operation.shapeType == ShapeType::Rectangle || operation.shapeType == ShapeType::Line;
+        valid = operation.color != ColorName::Invalid && operation.shapeType != ShapeType::Invalid && tokens.nextInt(operation.x) &&
+                tokens.nextInt(operation.y) && tokens.nextInt(operation.param1) && (!usesParam2 || tokens.nextInt(operation.param2));
+    }
+    else if (action == "move") {
+        operation.type = Board::Operation::Type::Move;
+        valid = tokens.nextInt(operation.id) && tokens.nextInt(operation.x) && tokens.nextInt(operation.y);
+    }
+    else if (action == "paint") {
+        operation.type = Board::Operation::Type::Paint;
+        valid = tokens.nextInt(operation.id) && (operation.color = Color::fromString(tokens.next())) != ColorName::Invalid;
+    }
+    else {
+        valid = false;
+    }
+    if (!valid || !tokens.atEnd()) {
+        reply += "Invalid ingest command. Expected format: ingest add fill|frame color shape x y param1 [param2], "
+                 "ingest move id x y, ingest paint id color or ingest stats\n";
+        return;
+    }
+    if (!ingestQueueOf(shared).tryPush(operation)) {
+        reply += "The ingest queue is full. Try again later.\n";
+        return;
+    }
+    reply += "Queued.\n";
+}
+
+// Serves the commands that only read the board under its shared lock. Returns false for anything else,
+// including malformed reads, which executeCommand then reports.
+bool Server::read(Session& session, std::string_view line, std::string& reply) {
+    Tokenizer tokens(line);
+    CommandType commandType = commandKeywords.find(tokens.next());
+    if (commandType != CommandType::Draw && commandType != CommandType::List && commandType != CommandType::Select) {
+        return false;
+    }
+
+    SharedBoard& shared = *session.shared;
+    const Board& board = shared.board;
+    std::shared_lock<std::shared_mutex> reading(shared.mutex);
+    if (commandType == CommandType::Draw) {
+        if (!board.isPrintable()) {
+            std::ostringstream output;
+            board.reportUnprintable(output);
+            reply += output.str();
+            return true;
+        }
+        // The grid is brought up to date by whichever reader finds it stale first; the frame is then
+        // printed alongside other readers. Clients always get the whole frame.
+        bool rendered = true;
+        while (rendered && !board.isRendered()) {
+            reading.unlock();
+            {
+                std::unique_lock<std::shared_mutex> writing(shared.mutex);
+                std::vector<Rect> tiles;
+                if (!shared.board.isRendered()) {
+                    rendered = shared.board.render(tiles);
+                }
+            }
+            reading.lock();
+        }
+        if (!rendered) {
+            std::ostringstream output;
+            board.reportUnrenderable(output);
+            reply += output.str();
+            return true;
+        }
+        board.appendFrame(reply);
+        return true;
+    }
+    if (commandType == CommandType::List) {
+        std::ostringstream output;
+        board.list(output);
+        reply += output.str();
+        return true;
+    }
+
+    int firstParam, y;
+    int id;
+    std::string at;
+    if (!tokens.nextInt(firstParam)) {
+        return false;
+    }
+    if (tokens.atEnd()) {
+        id = board.getFigures().find(firstParam) != nullptr ? firstParam : -1;
+        if (id == -1) {
+            reply += "Shape with ID " + std::to_string(firstParam) + " not found.\n";
+        }
+    }
+    else if (tokens.nextInt(y)) {
+        id = board.figureAt(firstParam, y);
+        at = " at (" + std::to_string(firstParam) + ", " + std::to_string(y) + ")";
+        if (id == -1) {
+            reply += "No shape found" + at + ".\n";
+        }
+    }
+    else {
+        return false;
+    }
+    session.selectedID = id;
+    if (id != -1) {
+        reply += "Shape [" + std::to_string(id) + "]" + at + " selected: " + board.getFigures().find(id)->getInfo() + '\n';
+    }
+    return true;
+}
+
+#ifdef _WIN32
+
+bool Server::run() {
+    std::cerr << "Server mode needs Unix domain sockets, which this build does not support." << std::endl;
+    return false;
+}
+
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+bool makeNonBlocking(int descriptor) {
+    int flags = ::fcntl(descriptor, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(descriptor, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+}
+
+bool Server::run() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path " << socketPath << " is empty or too long." << std::endl;
+        return false;
+    }
+    std::copy(socketPath.begin(), socketPath.end(), address.sun_path);
+
+    // A socket left behind by a server that did not shut down cleanly is replaced; any other file is not.
+    struct stat existing {};
+    if (::lstat(socketPath.c_str(), &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+        ::unlink(socketPath.c_str());
+    }
+
+    int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    int wakeEnds[2] = {-1, -1};
+    if (listener < 0 || ::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listener, SOMAXCONN) != 0 || !makeNonBlocking(listener) || ::pipe(wakeEnds) != 0 ||
+        !makeNonBlocking(wakeEnds[0]) || !makeNonBlocking(wakeEnds[1])) {
+        std::cerr << "Could not listen on " << socketPath << "." << std::endl;
+        for (int descriptor : {listener, wakeEnds[0], wakeEnds[1]}) {
+            if (descriptor >= 0) {
+                ::close(descriptor);
+            }
+        }
+        return false;
+    }
+    wakeRead = wakeEnds[0];
+    wakeWrite = wakeEnds[1];
+    std::cout << "Serving boards on " << socketPath << " with " << workers.size() << " worker threads." << std::endl;
+
+    // Waiting with a timeout lets a stop request from a signal handler be noticed without any locking.
+    std::vector<pollfd> waiting;
+    std::vector<Connection*> polled;
+    while (!stopRequested) {
+        waiting.assign({{listener, POLLIN, 0}, {wakeRead, POLLIN, 0}});
+        polled.clear();
+        for (auto& [descriptor, connection] : connections) {
+            short events = 0;
+            {
+                std::lock_guard<std::mutex> lock(connection->mutex);
+                if (!connection->closing && connection->lines.size() < maxQueuedLines && connection->output.size() < maxPendingOutput) {
+                    events |= POLLIN;
+                }
+                if (!connection->output.empty()) {
+                    events |= POLLOUT;
+                }
+            }
+            waiting.push_back({descriptor, events, 0});
+            polled.push_back(connection.get());
+        }
+        if (::poll(waiting.data(), waiting.size(), 200) <= 0) {
+            continue;
+        }
+
+        if (waiting[1].revents & POLLIN) {
+            char drained[256];
+            while (::read(wakeRead, drained, sizeof(drained)) > 0) {
+            }
+        }
+        for (std::size_t i = 0; i < polled.size(); ++i) {
+            Connection& connection = *polled[i];
+            short events = waiting[i + 2].revents;
+            bool healthy = true;
+            if (events & POLLOUT) {
+                healthy = send(connection);
+            }
+            if (healthy && (events & (POLLIN | POLLHUP | POLLERR))) {
+                healthy = receive(connection);
+            }
+            if (!healthy) {
+                std::lock_guard<std::mutex> lock(connection.mutex);
+                connection.broken = true;
+                connection.lines.clear();
+            }
+        }
+        for (auto it = connections.begin(); it != connections.end();) {
+            Connection& connection = *it->second;
+            bool finished;
+            {
+                std::lock_guard<std::mutex> lock(connection.mutex);
+                finished = !connection.running && (connection.broken || (connection.closing && connection.output.empty()));
+            }
+            if (finished) {
+                ::close(connection.descriptor);
+                it = connections.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        if (waiting[0].revents & POLLIN) {
+            int descriptor = ::accept(listener, nullptr, nullptr);
+            if (descriptor >= 0 && makeNonBlocking(descriptor)) {
+                connections.emplace(descriptor, std::make_unique<Connection>(descriptor, &boardNamed("default")));
+            }
+            else if (descriptor >= 0) {
+                ::close(descriptor);
+            }
+        }
+    }
+
+    ::close(listener);
+    ::unlink(socketPath.c_str());
+    for (auto& [descriptor, connection] : connections) {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->broken = true;
+        connection->lines.clear();
+    }
+    workers.wait();
+    for (auto& [descriptor, connection] : connections) {
+        ::close(descriptor);
+    }
+    connections.clear();
+    ::close(wakeRead);
+    ::close(wakeWrite);
+    for (auto& [name, shared] : boards) {
+        flushIngest(*shared);
+        shared->board.finishBackgroundSave();
+    }
+    std::cout << "Server stopped." << std::endl;
+    return true;
+}
+
+// Reads what the client sent and queues its complete lines, starting a worker on them if none is running.
+// Returns false once the client has gone or sent a line that is too long.
+bool Server::receive(Connection& connection) {
+    char buffer[4096];
+    ssize_t received = ::recv(connection.descriptor, buffer, sizeof(buffer), 0);
+    if (received < 0) {
+        return errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    if (received == 0) {
+        return false;
+    }
+    connection.input.append(buffer, static_cast<std::size_t>(received));
+
+    std::vector<std::string> complete;
+    std::size_t start = 0;
+    for (std::size_t end; (end = connection.input.find('\n', start)) != std::string::npos; start = end + 1) {
+        std::size_t length = end - start;
+        if (length > 0 && connection.input[end - 1] == '\r') {
+            --length;
+        }
+        complete.emplace_back(connection.input, start, length);
+    }
+    connection.input.erase(0, start);
+    if (connection.input.size() > maxLineLength) {
+        return false;
+    }
+    if (complete.empty()) {
+        return true;
+    }
+
+    bool idle;
+    {
+        std::lock_guard<std::mutex> lock(connection.mutex);
+        if (connection.closing) {
+            return true;
+        }
+        for (std::string& line : complete) {
+            connection.lines.push_back(std::move(line));
+        }
+        idle = !connection.running;
+        connection.running = true;
+    }
+    if (idle) {
+        workers.submit([this, &connection] { process(connection); });
+    }
+    return true;
+}
+
+// Writes as much pending output as the socket takes without blocking; returns false if the client has gone.
+bool Server::send(Connection& connection) {
+    std::lock_guard<std::mutex> lock(connection.mutex);
+    while (!connection.output.empty()) {
+        ssize_t written = ::send(connection.descriptor, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+        if (written < 0) {
+            return errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        connection.output.erase(0, static_cast<std::size_t>(written));
+    }
+    return true;
+}
+
+// Runs the connection's queued lines in order. After linesPerTurn lines the connection goes to the back of
+// the pool's queue; once its lines run out it is released, and from then on the poll thread may close it.
+void Server::process(Connection& connection) {
+    std::string reply;
+    for (int handled = 0; handled < linesPerTurn; ++handled) {
+        std::string line;
+        {
+            std::lock_guard<std::mutex> lock(connection.mutex);
+            if (connection.lines.empty()) {
+                connection.running = false;
+                break;
+            }
+            line = std::move(connection.lines.front());
+            connection.lines.pop_front();
+        }
+
+        reply.clear();
+        bool open = handle(connection.session, line, reply);
+        reply += '\0';
+        std::lock_guard<std::mutex> lock(connection.mutex);
+        connection.output += reply;
+        if (!open) {
+            connection.closing = true;
+            connection.lines.clear();
+        }
+        if (handled + 1 == linesPerTurn) {
+            if (connection.lines.empty()) {
+                connection.running = false;
+            }
+            else {
+                workers.submit([this, &connection] { process(connection); });
+            }
+        }
+    }
+    wake();
+}
+
+void Server::wake() {
+    char signal = 1;
+    ssize_t ignored = ::write(wakeWrite, &signal, 1);
+    (void)ignored;
+}
+
+#endif
@@ -0,0 +1,111 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include "board.h"
+#include "ingest.h"
+#include "thread_pool.h"
+#include "tokenizer.h"
+
+// Serves named boards to many clients over a Unix domain socket. Clients send command lines and get back
+// each command's output followed by a NUL byte. Every connection starts on the board "default";
+// "board <name>" switches to another, creating it on first use.
+//
+// One thread accepts connections and does all socket reads and writes with poll. Complete command lines
+// are queued on their connection and run on a shared pool of threadCount workers, one line at a time per
+// connection so replies keep their order; an idle connection holds no worker.
+//
+// draw, list and select only read a board and run concurrently under its shared lock; the selection they
+// make belongs to the connection. Every other command takes the board's exclusive lock and runs through
+// executeCommand as it would in the terminal, so writes to one board are serialized while other boards
+// stay available.
+//
+// "ingest add|move|paint ..." is the high-rate write path: it queues the edit on the board's ingest queue and
+// replies at once, and the queue's applier thread applies queued edits in batches under the exclusive lock.
+// A full queue is reported instead of waited on. Any other command on the board first waits for the edits
+// already queued, so a client always sees its own. "ingest stats" reports the queue's metrics.
+class Server {
+public:
+    Server(std::string socketPath, std::size_t threadCount);
+
+    // Serves connections until requestStop() is called; returns false if the socket could not be opened.
+    bool run();
+    // Safe to call from a signal handler.
+    static void requestStop();
+
+private:
+    struct SharedBoard {
+        std::shared_mutex mutex;
+        Board board;
+        // Started by the first ingest command, so boards that never use it cost no applier thread.
+        std::once_flag ingestStarted;
+        std::atomic<bool> ingestReady{false};
+        std::unique_ptr<IngestQueue> ingest;
+    };
+
+    // Results of a client's background saves. Whichever thread wrote the file leaves the result here, and the
+    // client gets it ahead of the reply to its next command.
+    struct Notices {
+        std::mutex mutex;
+        std::string text;
+    };
+
+    struct Session {
+        SharedBoard* shared;
+        int selectedID = -1;
+        std::shared_ptr<Notices> notices = std::make_shared<Notices>();
+    };
+
+    // lines and everything after them are shared between the poll thread and the worker running the
+    // connection's lines, and guarded by mutex; input belongs to the poll thread and session to the worker.
+    struct Connection {
+        Connection(int descriptor, SharedBoard* shared) : descriptor(descriptor), session{shared} {}
+
+        int descriptor;
+        Session session;
+        std::string input;
+        std::mutex mutex;
+        std::deque<std::string> lines;
+        std::string output;
+        bool running = false;
+        // The client sent exit: what is left of output is sent, then the connection is closed.
+        bool closing = false;
+        // The client went away or broke the protocol; the connection is closed as soon as no worker holds it.
+        bool broken = false;
+    };
+
+    SharedBoard& boardNamed(const std::string& name);
+    bool receive(Connection& connection);
+    bool send(Connection& connection);
+    void process(Connection& connection);
+    void wake();
+    // Runs one line for the session and appends what it printed to reply; returns false once the client leaves.
+    bool handle(Session& session, std::string_view line, std::string& reply);
+    bool read(Session& session, std::string_view line, std::string& reply);
+    void ingest(SharedBoard& shared, Tokenizer& tokens, std::string& reply);
+    static IngestQueue& ingestQueueOf(SharedBoard& shared);
+    static void flushIngest(SharedBoard& shared);
+
+    static constexpr std::size_t maxLineLength = 1 << 16;
+    // A connection is not read from while this many lines wait for a worker or this much output waits for
+    // the client, so a client that sends faster than it reads is held back instead of growing the queues.
+    static constexpr std::size_t maxQueuedLines = 256;
+    static constexpr std::size_t maxPendingOutput = 1 << 22;
+    // A worker hands a busy connection back to the pool after this many lines, so others get a turn.
+    static constexpr int linesPerTurn = 16;
+
+    std::string socketPath;
+    ThreadPool workers;
+    std::mutex boardsMutex;
+    std::map<std::string, std::unique_ptr<SharedBoard>, std::less<>> boards;
+    // Owned by the poll thread, which only destroys a connection while no worker is running it.
+    std::map<int, std::unique_ptr<Connection>> connections;
+    // Workers write a byte here when a connection has output or has finished, to end the poll early.
+    int wakeRead = -1;
+    int wakeWrite = -1;
+};
@@ -0,0 +1,136 @@
+#include "spatial_index.h"
+#include <algorithm>
+
+namespace {
+
+int floorDivide(int value, std::int64_t size) {
+    return static_cast<int>(value >= 0 ? value / size : -((-static_cast<std::int64_t>(value) + size - 1) / size));
+}
+
+}
+
+int SpatialIndex::levelFor(const Rect& bounds) const {
+    std::int64_t extent = std::max(static_cast<std::int64_t>(bounds.right) - bounds.left, static_cast<std::int64_t>(bounds.bottom) - bounds.top) + 1;
+    int level = 0;
+    while (bucketSize(level) < extent) {
+        ++level;
+    }
+    return level;
+}
+
+Rect SpatialIndex::bucketRange(const Rect& bounds, int level) const {
+    std::int64_t size = bucketSize(level);
+    return {floorDivide(bounds.left, size), floorDivide(bounds.top, size), floorDivide(bounds.right, size), floorDivide(bounds.bottom, size)};
+}
+
+std::int64_t SpatialIndex::bucketKey(int bx, int by) {
+    return static_cast<std::int64_t>((static_cast<std::uint64_t>(static_cast<std::uint32_t>(bx)) << 32) | static_cast<std::uint32_t>(by));
+}
+
+void SpatialIndex::insert(int id, const Rect& bounds) {
+    if (bounds.empty()) {
+        return;
+    }
+    remove(id);
+
+    int level = levelFor(bounds);
+    if (static_cast<std::size_t>(level) >= levels.size()) {
+        levels.resize(static_cast<std::size_t>(level) + 1);
+    }
+    Item& item = items[id];
+    item.bounds = bounds;
+    item.level = level;
+
+    Rect range = bucketRange(bounds, level);
+    int corner = 0;
+    for (int by = range.top; by <= range.bottom; ++by) {
+        for (int bx = range.left; bx <= range.right; ++bx, ++corner) {
+            std::vector<Entry>& bucket = levels[static_cast<std::size_t>(level)][bucketKey(bx, by)];
+            item.positions[static_cast<std::size_t>(corner)] = static_cast<std::uint32_t>(bucket.size());
+            bucket.push_back({id, corner});
+        }
+    }
+}
+
+// The last entry of each bucket moves into the freed position, and its item is told where it went.
+void SpatialIndex::remove(int id) {
+    auto it = items.find(id);
+    if (it == items.end()) {
+        return;
+    }
+
+    const Item& item = it->second;
+    Level& level = levels[static_cast<std::size_t>(item.level)];
+    Rect range = bucketRange(item.bounds, item.level);
+    int corner = 0;
+    for (int by = range.top; by <= range.bottom; ++by) {
+        for (int bx = range.left; bx <= range.right; ++bx, ++corner) {
+            auto bucket = level.find(bucketKey(bx, by));
+            std::uint32_t position = item.positions[static_cast<std::size_t>(corner)];
+            Entry moved = bucket->second.back();
+            bucket->second[position] = moved;
+            items.at(moved.id).positions[static_cast<std::size_t>(moved.corner)] = position;
+            bucket->second.pop_back();
+            if (bucket->second.empty()) {
+                level.erase(bucket);
+            }
+        }
+    }
+    items.erase(it);
+}
+
+void SpatialIndex::update(int id, const Rect& bounds) {
+    remove(id);
+    insert(id, bounds);
+}
+
+void SpatialIndex::clear() {
+    levels.clear();
+    items.clear();
+}
+
+std::vector<int> SpatialIndex::query(int x, int y) const {
+    return query(Rect{x, y, x, y});
+}
+
+std::vector<int> SpatialIndex::query(const Rect& region) const {
+    std::vector<int> result;
+    if (region.empty()) {
+        return result;
+    }
+
+    auto collect = [&](const std::vector<Entry>& bucket) {
+        for (const Entry& entry : bucket) {
+            if (items.at(entry.id).bounds.intersects(region)) {
+                result.push_back(entry.id);
+            }
+        }
+    };
+
+    for (std::size_t level = 0; level < levels.size(); ++level) {
+        const Level& buckets = levels[level];
+        if (buckets.empty()) {
+            continue;
+        }
+        Rect range = bucketRange(region, static_cast<int>(level));
+        if ((static_cast<long long>(range.right) - range.left + 1) * (static_cast<long long>(range.bottom) - range.top + 1) >
+            static_cast<long long>(buckets.size())) {
+            for (const auto& bucket : buckets) {
+                collect(bucket.second);
+            }
+            continue;
+        }
+        for (int by = range.top; by <= range.bottom; ++by) {
+            for (int bx = range.left; bx <= range.right; ++bx) {
+                auto bucket = buckets.find(bucketKey(bx, by));
+                if (bucket != buckets.end()) {
+                    collect(bucket->second);
+                }
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
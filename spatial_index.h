@@ -0,0 +1,45 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "rect.h"
+
+// Hierarchical grid: level L has buckets of cellSize << L cells, and each item goes to the lowest level whose
+// buckets are at least as large as the item, so it lands in at most 2 x 2 buckets however large it is.
+// Every item remembers where it sits in each of its buckets, so removal never searches a bucket.
+class SpatialIndex {
+public:
+    explicit SpatialIndex(int cellSize = 16) : cellSize(cellSize) {}
+
+    void insert(int id, const Rect& bounds);
+    void remove(int id);
+    void update(int id, const Rect& bounds);
+    void clear();
+
+    [[nodiscard]] std::vector<int> query(int x, int y) const;
+    [[nodiscard]] std::vector<int> query(const Rect& region) const;
+
+private:
+    // corner says which of the item's buckets this is, in row-major order within its bucket range.
+    struct Entry {
+        int id;
+        int corner;
+    };
+    using Level = std::unordered_map<std::int64_t, std::vector<Entry>>;
+
+    struct Item {
+        Rect bounds;
+        int level;
+        std::array<std::uint32_t, 4> positions;
+    };
+
+    [[nodiscard]] std::int64_t bucketSize(int level) const { return static_cast<std::int64_t>(cellSize) << level; }
+    [[nodiscard]] int levelFor(const Rect& bounds) const;
+    [[nodiscard]] Rect bucketRange(const Rect& bounds, int level) const;
+    static std::int64_t bucketKey(int bx, int by);
+
+    int cellSize;
+    std::vector<Level> levels;
+    std::unordered_map<int, Item> items;
+};
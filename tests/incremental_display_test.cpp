@@ -0,0 +1,155 @@
+// Checks that incremental draws leave the terminal showing exactly what a full draw prints, on boards
+// whose row labels are wider than two digits. Build from the repository root with
+//   g++ -std=c++17 -O2 -pthread -o tests/incremental_display_test tests/incremental_display_test.cpp $(ls *.cpp | grep -v '^main.cpp$')
+// It prints the cases that fail and exits with 1 if there are any.
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../board.h"
+#include "../command.h"
+
+namespace {
+
+// Plays the board's output onto a character grid, following the cursor moves, saves and restores it uses.
+// Color codes are dropped, since every glyph already names its color.
+class Screen {
+public:
+    void play(const std::string& output) {
+        for (std::size_t i = 0; i < output.size(); ++i) {
+            char c = output[i];
+            if (c == '\033') {
+                i = escape(output, i + 1);
+            }
+            else if (c == '\n') {
+                ++line;
+                column = 1;
+            }
+            else {
+                put(c);
+            }
+        }
+    }
+
+    [[nodiscard]] std::string text(std::size_t firstLine, std::size_t lastLine) const {
+        std::string result;
+        for (std::size_t i = firstLine; i <= lastLine && i <= lines.size(); ++i) {
+            result += lines[i - 1];
+            result += '\n';
+        }
+        return result;
+    }
+
+private:
+    std::size_t escape(const std::string& output, std::size_t i) {
+        if (output[i] == '7') {
+            savedLine = line;
+            savedColumn = column;
+            return i;
+        }
+        if (output[i] == '8') {
+            line = savedLine;
+            column = savedColumn;
+            return i;
+        }
+        std::size_t end = output.find_first_of("HJmr", i + 1);
+        std::string parameters = output.substr(i + 1, end - i - 1);
+        if (output[end] == 'H') {
+            std::size_t separator = parameters.find(';');
+            line = parameters.empty() ? 1 : std::stoul(parameters.substr(0, separator));
+            column = separator == std::string::npos ? 1 : std::stoul(parameters.substr(separator + 1));
+        }
+        else if (output[end] == 'J') {
+            lines.clear();
+        }
+        return end;
+    }
+
+    void put(char c) {
+        if (lines.size() < line) {
+            lines.resize(line);
+        }
+        std::string& text = lines[line - 1];
+        if (text.size() < column) {
+            text.resize(column, ' ');
+        }
+        text[column - 1] = c;
+        ++column;
+    }
+
+    std::vector<std::string> lines;
+    std::size_t line = 1;
+    std::size_t column = 1;
+    std::size_t savedLine = 1;
+    std::size_t savedColumn = 1;
+};
+
+std::string stripColors(const std::string& text) {
+    std::string result;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\033') {
+            i = text.find('m', i);
+        }
+        else {
+            result += text[i];
+        }
+    }
+    return result;
+}
+
+// Trailing blanks are not compared, since the screen only holds what was written to it.
+std::string trimLines(const std::string& text) {
+    std::istringstream input(text);
+    std::string result;
+    for (std::string line; std::getline(input, line);) {
+        line.erase(line.find_last_not_of(' ') + 1);
+        result += line + '\n';
+    }
+    return result;
+}
+
+// Runs setup, draws in incremental mode, runs each edit followed by a draw, and compares the screen with a full print.
+bool check(const std::string& name, const std::vector<std::string>& setup, const std::vector<std::string>& edits) {
+    std::ostringstream output;
+    Board board;
+    board.setOutput(output, output);
+    board.setQuiet(true);
+    for (const std::string& command : setup) {
+        executeCommand(board, command);
+    }
+    board.setDisplayMode(DisplayMode::Incremental);
+    board.draw();
+    for (const std::string& command : edits) {
+        executeCommand(board, command);
+        board.draw();
+    }
+
+    Screen screen;
+    screen.play(output.str());
+    std::string expected;
+    board.appendFrame(expected);
+    expected = trimLines(stripColors(expected));
+    std::string shown = trimLines(screen.text(1, static_cast<std::size_t>(board.displayRows()) + 3));
+    if (shown != expected) {
+        std::cout << name << ": incremental screen differs from a full draw.\nExpected:\n" << expected << "Shown:\n" << shown;
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main() {
+    int failures = 0;
+    failures += !check("rows past 99", {"resize 20 120", "add fill red rectangle 2 95 4 10"},
+                       {"select 0", "move 5 110", "paint blue", "add frame green circle 10 112 3"});
+    failures += !check("viewport origin past 99", {"resize 300 300", "add fill red circle 150 150 5", "viewport 140 140 30 20"},
+                       {"select 0", "move 155 152", "add frame cyan line 141 141 168 158"});
+    failures += !check("zoomed labels past 999", {"resize 5000 5000", "add fill red rectangle 1000 1000 40 40", "viewport 990 990 80 60 2"},
+                       {"select 0", "move 1010 1020", "paint yellow"});
+    failures += !check("two digit labels", {"resize 20 12", "add fill red circle 5 5 3"}, {"select 0", "move 12 6", "undo", "redo"});
+    if (failures == 0) {
+        std::cout << "All incremental display checks passed.\n";
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+// Checks that drawing thin figures on very large boards only touches the tiles they draw on, so memory and time
+// follow what is drawn rather than the size of the board, and that a draw which truly needs too many tiles is
+// refused. Build from the repository root with
+//   g++ -std=c++17 -O2 -pthread -o tests/large_board_test tests/large_board_test.cpp $(ls *.cpp | grep -v '^main.cpp$')
+// It prints the cases that fail and exits with 1 if there are any.
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../board.h"
+#include "../command.h"
+
+namespace {
+
+// A board-spanning outline or line on an n x n board draws on about 4n / 64 tiles; the bound leaves room for that.
+bool checkRender(const std::string& name, const std::vector<std::string>& setup, std::size_t maxTiles) {
+    std::ostringstream output;
+    Board board;
+    board.setOutput(output, output);
+    board.setQuiet(true);
+    for (const std::string& command : setup) {
+        executeCommand(board, command);
+    }
+    std::vector<Rect> tiles;
+    if (!board.render(tiles)) {
+        std::cout << name << ": rendering was refused.\n";
+        return false;
+    }
+    if (board.grid.allocatedTiles() > maxTiles) {
+        std::cout << name << ": rendering allocated " << board.grid.allocatedTiles() << " tiles, expected at most " << maxTiles << ".\n";
+        return false;
+    }
+    for (int x : {0, 500000, 999999}) {
+        if (board.grid.at(x, 0) == Framebuffer::emptyCell) {
+            std::cout << name << ": cell (" << x << ", 0) was not drawn.\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// A viewport showing the whole board at a large zoom prints a handful of cells, so it must not render the board.
+bool checkViewport(const std::string& name, const std::vector<std::string>& setup, std::size_t maxTiles) {
+    std::ostringstream output;
+    Board board;
+    board.setOutput(output, output);
+    board.setQuiet(true);
+    for (const std::string& command : setup) {
+        executeCommand(board, command);
+    }
+    executeCommand(board, "viewport 0 0 1000000 1000000 50000");
+    executeCommand(board, "draw");
+    if (board.getErrorCount() != 0 || board.displayColumns() != 20) {
+        std::cout << name << ": the zoomed draw failed:\n" << output.str();
+        return false;
+    }
+    if (board.grid.allocatedTiles() > maxTiles) {
+        std::cout << name << ": drawing the viewport allocated " << board.grid.allocatedTiles() << " tiles, expected at most " << maxTiles << ".\n";
+        return false;
+    }
+    std::vector<Framebuffer::Cell> line;
+    board.sampleRow(board.grid, 0, 0, board.displayColumns() - 1, line);
+    for (Framebuffer::Cell cell : line) {
+        if (cell == Framebuffer::emptyCell) {
+            std::cout << name << ": the top row of the zoomed view has a blank cell.\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// A filled figure covering the board really does draw on every tile, so drawing it is refused instead of run out of memory.
+bool checkRefused(const std::string& name, const std::vector<std::string>& setup) {
+    std::ostringstream output;
+    Board board;
+    board.setOutput(output, output);
+    board.setQuiet(true);
+    for (const std::string& command : setup) {
+        executeCommand(board, command);
+    }
+    executeCommand(board, "draw");
+    if (board.getErrorCount() != 1 || output.str().find("Use viewport to show a smaller window") == std::string::npos ||
+        board.grid.allocatedTiles() != 0 || board.isRendered()) {
+        std::cout << name << ": the draw was not refused cleanly:\n" << output.str();
+        return false;
+    }
+    executeCommand(board, "viewport 0 0 1000 1000 50");
+    executeCommand(board, "draw");
+    if (board.getErrorCount() != 1) {
+        std::cout << name << ": a smaller viewport still could not be drawn:\n" << output.str();
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main() {
+    int failures = 0;
+    failures += !checkRender("frame spanning the board", {"resize 1000000 1000000", "add frame red rectangle 0 0 1000000 1000000"}, 64000);
+    failures += !checkRender("line across the board", {"resize 1000000 1000000", "add frame red line 0 0 999999 999999",
+                                                       "add frame blue line 0 999999 999999 0", "add frame green line 0 0 999999 0"}, 64000);
+    failures += !checkViewport("zoomed frame spanning the board", {"resize 1000000 1000000", "add frame red rectangle 0 0 1000000 1000000"}, 64000);
+    failures += !checkViewport("zoomed line across the board", {"resize 1000000 1000000", "add frame red line 0 0 999999 0",
+                                                                "add frame blue line 0 999999 999999 0"}, 64000);
+    failures += !checkRefused("zoomed fill spanning the board", {"resize 1000000 1000000", "add fill red rectangle 0 0 1000000 1000000",
+                                                                 "viewport 0 0 1000000 1000000 50000"});
+    if (failures == 0) {
+        std::cout << "All large board checks passed.\n";
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+
+ThreadPool::ThreadPool(std::size_t threadCount) {
+    threadCount = std::max<std::size_t>(threadCount, 1);
+    workers.reserve(threadCount);
+    for (std::size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+        ++activeTasks;
+    }
+    taskAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    tasksDone.wait(lock, [this] { return activeTasks == 0; });
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& body) {
+    std::atomic<std::size_t> next{0};
+    std::size_t runners = std::min(count, workers.size());
+    std::size_t finishedRunners = 0;
+    std::mutex finishedMutex;
+    std::condition_variable allFinished;
+
+    for (std::size_t i = 0; i < runners; ++i) {
+        submit([&] {
+            for (std::size_t index = next++; index < count; index = next++) {
+                body(index);
+            }
+            std::lock_guard<std::mutex> lock(finishedMutex);
+            if (++finishedRunners == runners) {
+                allFinished.notify_one();
+            }
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(finishedMutex);
+    allFinished.wait(lock, [&] { return finishedRunners == runners; });
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --activeTasks;
+        }
+        tasksDone.notify_all();
+    }
+}
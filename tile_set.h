@@ -0,0 +1,57 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <utility>
+#include <vector>
+#include "framebuffer.h"
+#include "rect.h"
+
+// The tiles a figure draws on inside a clip, gathered by rasterizing the figure into it. Each row of tiles keeps
+// runs of tile columns, and a span that touches one of the last two runs of its row extends it, so an outline,
+// whose rows alternate between two edges, costs a few runs per row of tiles rather than one per cell.
+class TileSet {
+public:
+    explicit TileSet(const Rect& clip)
+            : origin(Framebuffer::tileArea(clip.left, clip.top)),
+              rows(static_cast<std::size_t>((clip.bottom - origin.top) / Framebuffer::tileSize) + 1) {}
+
+    void set(int x, int y, Framebuffer::Cell cell) { fillSpan(y, x, x, cell); }
+    void fillSpan(int row, int left, int right, Framebuffer::Cell) {
+        std::vector<Run>& runs = rows[static_cast<std::size_t>((row - origin.top) / Framebuffer::tileSize)];
+        int first = (left - origin.left) / Framebuffer::tileSize;
+        int last = (right - origin.left) / Framebuffer::tileSize;
+        for (std::size_t i = runs.size(); i-- > 0 && i + 2 >= runs.size();) {
+            if (first <= runs[i].second + 1 && last + 1 >= runs[i].first) {
+                runs[i] = {std::min(runs[i].first, first), std::max(runs[i].second, last)};
+                return;
+            }
+        }
+        runs.emplace_back(first, last);
+    }
+
+    // Calls visit with the top-left corner of every tile drawn on, once each, until it returns false.
+    template<typename Visit>
+    void forEach(Visit visit) {
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            std::vector<Run>& runs = rows[i];
+            std::sort(runs.begin(), runs.end());
+            int top = origin.top + static_cast<int>(i) * Framebuffer::tileSize;
+            int next = INT_MIN;
+            for (const Run& run : runs) {
+                for (int column = std::max(run.first, next); column <= run.second; ++column) {
+                    if (!visit(origin.left + column * Framebuffer::tileSize, top)) {
+                        return;
+                    }
+                }
+                next = std::max(next, run.second + 1);
+            }
+        }
+    }
+
+private:
+    // First and last tile column, counted from the origin.
+    using Run = std::pair<int, int>;
+
+    Rect origin;
+    std::vector<std::vector<Run>> rows;
+};
@@ -0,0 +1,52 @@
+#include "tokenizer.h"
+#include <charconv>
+
+namespace {
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+bool isSeparator(char c) {
+    return isSpace(c) || c == ',';
+}
+
+}
+
+std::string_view Tokenizer::next() {
+    std::size_t begin = 0;
+    while (begin < rest.size() && isSeparator(rest[begin])) {
+        ++begin;
+    }
+    std::size_t end = begin;
+    while (end < rest.size() && !isSeparator(rest[end])) {
+        ++end;
+    }
+    std::string_view token = rest.substr(begin, end - begin);
+    rest.remove_prefix(end);
+    return token;
+}
+
+bool Tokenizer::nextInt(int& value) {
+    return parseInt(next(), value);
+}
+
+bool Tokenizer::atEnd() const {
+    for (char c : rest) {
+        if (!isSeparator(c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Tokenizer::parseInt(std::string_view token, int& value) {
+    if (!token.empty() && token.front() == '+') {
+        token.remove_prefix(1);
+    }
+    if (token.empty()) {
+        return false;
+    }
+    auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+    return error == std::errc() && end == token.data() + token.size();
+}
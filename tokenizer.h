@@ -0,0 +1,19 @@
+#pragma once
+#include <string_view>
+
+// Splits a line into tokens separated by whitespace or commas, without copying it.
+class Tokenizer {
+public:
+    explicit Tokenizer(std::string_view text) : rest(text) {}
+
+    // Returns the next token, or an empty view once the line is exhausted.
+    std::string_view next();
+    // Reads the next token as a whole decimal integer; on failure the token is still consumed.
+    bool nextInt(int& value);
+    [[nodiscard]] bool atEnd() const;
+
+    static bool parseInt(std::string_view token, int& value);
+
+private:
+    std::string_view rest;
+};
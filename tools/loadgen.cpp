@@ -0,0 +1,272 @@
+// Load generator for server mode. Build from the repository root with
+//   g++ -std=c++17 -O2 -pthread -o tools/loadgen tools/loadgen.cpp
+// then start a server (app --serve /tmp/boards.sock) and run tools/loadgen --socket /tmp/boards.sock.
+// Each client connects, picks one of the shared boards and sends a random mix of reads (draw, list,
+// select) and writes (add, move, paint). Latency percentiles and throughput are printed as JSON.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+struct Options {
+    std::string socketPath = "/tmp/boards.sock";
+    int clients = 8;
+    int requests = 1000;
+    int writePercent = 20;
+    int boards = 2;
+    int boardWidth = 60;
+    int boardHeight = 30;
+    unsigned seed = 1;
+};
+
+struct ClientResult {
+    std::vector<double> readLatencies;
+    std::vector<double> writeLatencies;
+    std::size_t replyBytes = 0;
+    bool failed = false;
+};
+
+class Connection {
+public:
+    explicit Connection(const std::string& socketPath) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            return;
+        }
+        std::memcpy(address.sun_path, socketPath.data(), socketPath.size());
+        descriptor = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (descriptor >= 0 && ::connect(descriptor, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(descriptor);
+            descriptor = -1;
+        }
+    }
+    ~Connection() {
+        if (descriptor >= 0) {
+            ::close(descriptor);
+        }
+    }
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    [[nodiscard]] bool isOpen() const { return descriptor >= 0; }
+
+    // Sends one command and reads its reply up to the terminating NUL byte.
+    bool request(const std::string& line, std::string& reply) {
+        std::string message = line + '\n';
+        for (std::size_t sent = 0; sent < message.size();) {
+            ssize_t written = ::send(descriptor, message.data() + sent, message.size() - sent, MSG_NOSIGNAL);
+            if (written <= 0) {
+                return false;
+            }
+            sent += static_cast<std::size_t>(written);
+        }
+
+        reply.clear();
+        while (true) {
+            std::size_t end = pending.find('\0');
+            if (end != std::string::npos) {
+                reply.assign(pending, 0, end);
+                pending.erase(0, end + 1);
+                return true;
+            }
+            char buffer[65536];
+            ssize_t received = ::recv(descriptor, buffer, sizeof(buffer), 0);
+            if (received <= 0) {
+                return false;
+            }
+            pending.append(buffer, static_cast<std::size_t>(received));
+        }
+    }
+
+private:
+    int descriptor = -1;
+    std::string pending;
+};
+
+void runClient(const Options& options, int client, ClientResult& result) {
+    static const char* const colors[] = {"red", "green", "blue", "yellow", "cyan", "magenta", "white"};
+    static const char* const shapes[] = {"circle", "rectangle", "triangle", "line"};
+
+    Connection connection(options.socketPath);
+    std::string reply;
+    std::string board = "load" + std::to_string(client % options.boards);
+    if (!connection.isOpen() || !connection.request("board " + board, reply) ||
+        !connection.request("resize " + std::to_string(options.boardWidth) + " " + std::to_string(options.boardHeight), reply)) {
+        result.failed = true;
+        return;
+    }
+
+    std::mt19937 random(options.seed * 7919 + static_cast<unsigned>(client));
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<int> pickX(0, options.boardWidth - 1);
+    std::uniform_int_distribution<int> pickY(0, options.boardHeight - 1);
+    std::uniform_int_distribution<int> pickSize(1, 8);
+    std::uniform_int_distribution<int> pickColor(0, 6);
+    std::uniform_int_distribution<int> pickShape(0, 3);
+    std::uniform_int_distribution<int> pickRead(0, 2);
+    std::uniform_int_distribution<int> pickWrite(0, 2);
+
+    for (int i = 0; i < options.requests; ++i) {
+        std::string line;
+        bool write = percent(random) < options.writePercent;
+        if (write) {
+            switch (pickWrite(random)) {
+                case 0: {
+                    int shape = pickShape(random);
+                    line = std::string(percent(random) < 50 ? "add fill " : "add frame ") + colors[pickColor(random)] + " " + shapes[shape] + " " +
+                           std::to_string(pickX(random)) + " " + std::to_string(pickY(random)) + " " + std::to_string(pickSize(random));
+                    if (shape == 1 || shape == 3) {
+                        line += " " + std::to_string(pickSize(random));
+                    }
+                    break;
+                }
+                case 1:
+                    line = "move " + std::to_string(pickX(random)) + " " + std::to_string(pickY(random));
+                    break;
+                default:
+                    line = std::string("paint ") + colors[pickColor(random)];
+                    break;
+            }
+        }
+        else {
+            switch (pickRead(random)) {
+                case 0:
+                    line = "draw";
+                    break;
+                case 1:
+                    line = "list";
+                    break;
+                default:
+                    line = "select " + std::to_string(pickX(random)) + " " + std::to_string(pickY(random));
+                    break;
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (!connection.request(line, reply)) {
+            result.failed = true;
+            return;
+        }
+        double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        (write ? result.writeLatencies : result.readLatencies).push_back(elapsed);
+        result.replyBytes += reply.size();
+    }
+    connection.request("exit", reply);
+}
+
+bool parseNumber(const char* text, int& value) {
+    char* end;
+    long parsed = std::strtol(text, &end, 10);
+    if (*text == '\0' || *end != '\0' || parsed < 0 || parsed > 1000000) {
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    if (argc % 2 == 0) {
+        return false;
+    }
+    for (int i = 1; i < argc; i += 2) {
+        std::string option = argv[i];
+        const char* value = argv[i + 1];
+        bool valid;
+        if (option == "--socket") {
+            options.socketPath = value;
+            valid = true;
+        }
+        else if (option == "--clients") {
+            valid = parseNumber(value, options.clients) && options.clients > 0;
+        }
+        else if (option == "--requests") {
+            valid = parseNumber(value, options.requests);
+        }
+        else if (option == "--writes") {
+            valid = parseNumber(value, options.writePercent) && options.writePercent <= 100;
+        }
+        else if (option == "--boards") {
+            valid = parseNumber(value, options.boards) && options.boards > 0;
+        }
+        else if (option == "--width") {
+            valid = parseNumber(value, options.boardWidth) && options.boardWidth > 0;
+        }
+        else if (option == "--height") {
+            valid = parseNumber(value, options.boardHeight) && options.boardHeight > 0;
+        }
+        else if (option == "--seed") {
+            int seed;
+            valid = parseNumber(value, seed);
+            options.seed = static_cast<unsigned>(seed);
+        }
+        else {
+            valid = false;
+        }
+        if (!valid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void writeLatencies(std::ostream& output, const char* name, std::vector<double>& latencies) {
+    std::sort(latencies.begin(), latencies.end());
+    auto at = [&latencies](double fraction) {
+        return latencies.empty() ? 0.0 : latencies[std::min(latencies.size() - 1, static_cast<std::size_t>(fraction * static_cast<double>(latencies.size())))];
+    };
+    output << "  \"" << name << "\": {\"count\": " << latencies.size() << ", \"p50_us\": " << at(0.5) << ", \"p90_us\": " << at(0.9)
+           << ", \"p99_us\": " << at(0.99) << ", \"max_us\": " << (latencies.empty() ? 0.0 : latencies.back()) << "}";
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " [--socket path] [--clients N] [--requests N] [--writes percent] [--boards N]"
+                  << " [--width N] [--height N] [--seed N]" << std::endl;
+        return 2;
+    }
+
+    std::vector<ClientResult> results(static_cast<std::size_t>(options.clients));
+    std::vector<std::thread> clients;
+    auto start = std::chrono::steady_clock::now();
+    for (int client = 0; client < options.clients; ++client) {
+        clients.emplace_back(runClient, std::cref(options), client, std::ref(results[static_cast<std::size_t>(client)]));
+    }
+    for (std::thread& client : clients) {
+        client.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    ClientResult total;
+    int failedClients = 0;
+    for (const ClientResult& result : results) {
+        total.readLatencies.insert(total.readLatencies.end(), result.readLatencies.begin(), result.readLatencies.end());
+        total.writeLatencies.insert(total.writeLatencies.end(), result.writeLatencies.begin(), result.writeLatencies.end());
+        total.replyBytes += result.replyBytes;
+        failedClients += result.failed;
+    }
+    std::size_t requests = total.readLatencies.size() + total.writeLatencies.size();
+
+    std::cout << "{\n  \"clients\": " << options.clients << ",\n  \"boards\": " << options.boards << ",\n  \"failed_clients\": " << failedClients
+              << ",\n  \"requests\": " << requests << ",\n  \"seconds\": " << seconds << ",\n  \"requests_per_second\": "
+              << static_cast<double>(requests) / seconds << ",\n  \"reply_bytes\": " << total.replyBytes << ",\n";
+    writeLatencies(std::cout, "reads", total.readLatencies);
+    std::cout << ",\n";
+    writeLatencies(std::cout, "writes", total.writeLatencies);
+    std::cout << "\n}\n";
+    return failedClients > 0 ? 1 : 0;
+}